@@ -0,0 +1,242 @@
+#include "AbcArchiveIndex.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+#include "AbcThreadPool.h"
+#include "AbcArchivePool.h"
+#include "AbcQuantize.h"
+
+//! Components per element of a property AbcWriter stored encoded. Half and quantized16 vectors are stored as
+//! scalars, their declared type (or else the param's arrayExtent) tells how many make one element.
+static int encodedExtent(const Alembic::Abc::MetaData& metaData, int storedExtent)
+{
+	const std::string type = metaData.get(ABC_TYPE_KEY);
+	if(type == "vector")
+		return 3;
+	if(type == "float")
+		return 1;
+
+	const std::string arrayExtent = metaData.get("arrayExtent");
+	return arrayExtent.empty() ? storedExtent : std::max(std::atoi(arrayExtent.c_str()), storedExtent);
+}
+
+//! The PROP_TYPE AbcReader reads a param as, NUM_PROP_TYPES if none
+static PROP_TYPE propertyType(const Alembic::Abc::PropertyHeader& header, const std::string& encoding, int extent)
+{
+	using namespace Alembic::AbcGeom;
+
+	//reduced precision properties written by AbcWriter decode to plain floats
+	if(!encoding.empty())
+	{
+		return extent == 3 ? VECTOR : FLOAT;
+	}
+
+	if(IFloatGeomParam::matches(header))
+		return FLOAT;
+	if(IC3fGeomParam::matches(header) || IN3fGeomParam::matches(header) || IP3fGeomParam::matches(header) || IV3fGeomParam::matches(header))
+		return VECTOR;
+	if(IInt32GeomParam::matches(header))
+		return INT;
+	if(IV2fGeomParam::matches(header))
+		return VECTOR2;
+	if(IQuatfGeomParam::matches(header))
+		return QUAT;
+	if(IStringGeomParam::matches(header))
+		return STRING;
+	return NUM_PROP_TYPES;
+}
+
+static void describeProperties(const Alembic::AbcGeom::ICompoundProperty& arbGeomPs, std::vector<AbcPropertyInfo>& properties)
+{
+	if(!arbGeomPs.valid())
+	{
+		return;
+	}
+
+	for(size_t i = 0; i < arbGeomPs.getNumProperties(); ++i)
+	{
+		const Alembic::Abc::PropertyHeader& header = arbGeomPs.getPropertyHeader(i);
+		const Alembic::Abc::MetaData& metaData = header.getMetaData();
+
+		AbcPropertyInfo info;
+		info.name = header.getName();
+		info.encoding = metaData.get(ABC_ENCODING_KEY);
+		info.alembicScope = Alembic::AbcGeom::GetGeometryScope(metaData);
+		info.scope = info.alembicScope == Alembic::AbcGeom::kVertexScope ? VERTEX
+			: info.alembicScope == Alembic::AbcGeom::kFacevaryingScope ? FACE : POINT;
+
+		//indexed params are compounds of .vals and .indices
+		info.indexed = header.isCompound();
+		Alembic::AbcCoreAbstract::DataType dataType;
+		if(info.indexed)
+		{
+			const Alembic::Abc::PropertyHeader* vals = Alembic::Abc::ICompoundProperty(arbGeomPs, info.name).getPropertyHeader(".vals");
+			if(vals)
+			{
+				dataType = vals->getDataType();
+			}
+		}
+		else
+		{
+			dataType = header.getDataType();
+		}
+		info.pod = dataType.getPod();
+		info.extent = dataType.getExtent();
+		if(!info.encoding.empty())
+		{
+			info.extent = encodedExtent(metaData, info.extent);
+		}
+		info.type = propertyType(header, info.encoding, info.extent);
+		properties.push_back(info);
+	}
+}
+
+//! An object without its children
+static AbcObjectInfo describeObject(const Alembic::Abc::IObject& object, const std::string& path, int parent)
+{
+	AbcObjectInfo info;
+	info.path = path;
+	info.name = object.getName();
+	info.parent = parent;
+	info.type = OBJECT_OTHER;
+	info.numSamples = 0;
+	info.topologyVariance = Alembic::AbcGeom::kConstantTopology;
+	info.object = object;
+
+	const Alembic::Abc::MetaData& metaData = object.getMetaData();
+	if(Alembic::AbcGeom::IPolyMesh::matches(metaData))
+	{
+		Alembic::AbcGeom::IPolyMesh mesh(object, Alembic::AbcGeom::kWrapExisting);
+		Alembic::AbcGeom::IPolyMeshSchema& schema = mesh.getSchema();
+		info.type = OBJECT_POLYMESH;
+		info.numSamples = schema.getNumSamples();
+		info.timeSampling = schema.getTimeSampling();
+		info.topologyVariance = schema.getTopologyVariance();
+		describeProperties(schema.getArbGeomParams(), info.properties);
+	}
+	else if(Alembic::AbcGeom::IXform::matches(metaData))
+	{
+		Alembic::AbcGeom::IXform xform(object, Alembic::AbcGeom::kWrapExisting);
+		info.type = OBJECT_XFORM;
+		info.numSamples = xform.getSchema().getNumSamples();
+		info.timeSampling = xform.getSchema().getTimeSampling();
+	}
+	return info;
+}
+
+//! Appends object and everything below it to objects, depth first. parent is an index into objects (-1 = none).
+static void indexSubtree(const Alembic::Abc::IObject& object, const std::string& path, int parent, bool parallel,
+	std::vector<AbcObjectInfo>& objects)
+{
+	const int self = (int)objects.size();
+	objects.push_back(describeObject(object, path, parent));
+
+	const size_t numChildren = object.getNumChildren();
+	const std::string prefix = path == "/" ? path : path + "/";
+	if(!parallel || numChildren < 2)
+	{
+		for(size_t i = 0; i < numChildren; ++i)
+		{
+			objects[self].children.push_back((int)objects.size());
+			Alembic::Abc::IObject child = object.getChild(i);
+			indexSubtree(child, prefix + child.getName(), self, parallel, objects);
+		}
+		return;
+	}
+
+	//every subtree into its own table, then renumbered into ours in order
+	std::vector<std::vector<AbcObjectInfo>> subtrees(numChildren);
+	AbcThreadPool::defaultPool().parallelFor(numChildren, [&](size_t i)
+	{
+		Alembic::Abc::IObject child = object.getChild(i);
+		indexSubtree(child, prefix + child.getName(), -1, parallel, subtrees[i]);
+	});
+
+	for(auto& subtree : subtrees)
+	{
+		const int offset = (int)objects.size();
+		objects[self].children.push_back(offset);
+		for(auto& info : subtree)
+		{
+			info.parent = info.parent < 0 ? self : info.parent + offset;
+			for(auto& child : info.children)
+			{
+				child += offset;
+			}
+			objects.push_back(std::move(info));
+		}
+	}
+}
+
+AbcArchiveIndex::AbcArchiveIndex()
+{
+}
+
+bool AbcArchiveIndex::build(const std::string& file, bool parallel)
+{
+	std::shared_ptr<Alembic::Abc::IArchive> archive = AbcArchivePool::defaultPool().acquire(file);
+	return archive && build(archive, parallel);
+}
+
+bool AbcArchiveIndex::build(const std::shared_ptr<Alembic::Abc::IArchive>& archive, bool parallel)
+{
+	m_archive.reset();
+	m_objects.clear();
+	m_paths.clear();
+
+	if(!archive || !archive->valid())
+	{
+		std::cout << "ERROR: Invalid Alembic Archive, cannot index it." << std::endl;
+		return false;
+	}
+	m_archive = archive;
+
+	indexSubtree(archive->getTop(), "/", -1, parallel, m_objects);
+
+	m_paths.reserve(m_objects.size());
+	for(size_t i = 0; i < m_objects.size(); ++i)
+	{
+		m_paths.emplace(m_objects[i].path, (int)i);
+	}
+	return true;
+}
+
+const AbcObjectInfo* AbcArchiveIndex::find(const std::string& path) const
+{
+	auto it = m_paths.find(path.empty() || path[0] != '/' ? "/" + path : path);
+	return it == m_paths.end() ? nullptr : &m_objects[it->second];
+}
+
+std::vector<std::string> AbcArchiveIndex::getPaths(OBJECT_TYPE type) const
+{
+	std::vector<std::string> paths;
+	for(auto& object : m_objects)
+	{
+		if(object.type == type)
+		{
+			paths.push_back(object.path);
+		}
+	}
+	return paths;
+}
+
+std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> AbcArchiveIndex::getPropertyList(const std::string& path) const
+{
+	std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> properties;
+	const AbcObjectInfo* object = find(path);
+	if(!object)
+	{
+		return properties;
+	}
+
+	for(auto& p : object->properties)
+	{
+		if(p.type != NUM_PROP_TYPES)
+		{
+			properties.push_back(std::make_tuple(p.name, p.type, p.scope));
+		}
+	}
+	return properties;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <memory>
+#include <unordered_map>
+
+#include <Alembic/Abc/All.h>
+#include <Alembic/AbcGeom/All.h>
+
+#include "easyAbcUtil.h"
+
+//! One arbGeomParam of a mesh as found in the archive
+struct AbcPropertyInfo
+{
+	std::string name;
+	//NUM_PROP_TYPES if AbcReader cannot read it
+	PROP_TYPE type;
+	//kVarying -> POINT, kVertex -> VERTEX, kFacevarying -> FACE, anything else POINT (see alembicScope)
+	PROP_SCOPE scope;
+	Alembic::AbcGeom::GeometryScope alembicScope;
+	Alembic::Util::PlainOldDataType pod;
+	//components per element, for encoded properties those of the decoded values (3 for a VECTOR stored as half scalars)
+	int extent;
+	bool indexed;
+	//"half", "quantized16" or "unorm8" for properties AbcWriter stored encoded, empty otherwise
+	std::string encoding;
+};
+
+//! One object of the hierarchy with what is needed to bind a reader to it
+struct AbcObjectInfo
+{
+	//full path, "/" for the top object
+	std::string path;
+	std::string name;
+	//index of the parent in AbcArchiveIndex::getObjects(), -1 for the top object
+	int parent;
+	std::vector<int> children;
+
+	OBJECT_TYPE type;
+	//xforms and meshes only, 0 and null for everything else
+	size_t numSamples;
+	Alembic::AbcCoreAbstract::TimeSamplingPtr timeSampling;
+	//meshes only
+	Alembic::AbcGeom::MeshTopologyVariance topologyVariance;
+	std::vector<AbcPropertyInfo> properties;
+
+	//resolved once, readers bind to it without looking it up again
+	Alembic::Abc::IObject object;
+};
+
+//! Flat table of every object of an archive, built in one walk over the hierarchy.
+//! Lookup by path is O(1), objects are stored depth first with parents before their children.
+class AbcArchiveIndex
+{
+public:
+	AbcArchiveIndex();
+
+	//! Walk the whole hierarchy of archive. parallel indexes sibling subtrees concurrently on the default
+	//! thread pool, which pays off for wide hierarchies of archives opened with several Ogawa streams.
+	bool build(const std::shared_ptr<Alembic::Abc::IArchive>& archive, bool parallel = false);
+	//! Same for a file, opened through AbcArchivePool::defaultPool()
+	bool build(const std::string& file, bool parallel = false);
+
+	const std::shared_ptr<Alembic::Abc::IArchive>& getArchive() const { return m_archive; }
+	const std::vector<AbcObjectInfo>& getObjects() const { return m_objects; }
+
+	//! nullptr if there is no object at path ("/xform/mesh", the leading slash is optional)
+	const AbcObjectInfo* find(const std::string& path) const;
+	//! Paths of all objects of type, in hierarchy order
+	std::vector<std::string> getPaths(OBJECT_TYPE type) const;
+
+	//! Every property of the mesh at path AbcReader can read, as the list openArchive takes
+	std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> getPropertyList(const std::string& path) const;
+
+private:
+	std::shared_ptr<Alembic::Abc::IArchive> m_archive;
+	std::vector<AbcObjectInfo> m_objects;
+	std::unordered_map<std::string, int> m_paths;
+};
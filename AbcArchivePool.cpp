@@ -0,0 +1,166 @@
+#include "AbcArchivePool.h"
+
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#include <sys/stat.h>
+
+#include <Alembic/AbcCoreHDF5/All.h>
+#include <Alembic/AbcCoreOgawa/All.h>
+#include <Alembic/AbcCoreFactory/All.h>
+
+static int64_t nowNanos()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+AbcArchivePool::AbcArchivePool() : m_stop(false), m_numStreams(1), m_idleTimeout(0.0)
+{
+	m_cache = Alembic::AbcCoreHDF5::CreateCache();
+	m_reaper = boost::thread(&AbcArchivePool::reap, this);
+}
+
+AbcArchivePool::~AbcArchivePool()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+	m_reaper.join();
+}
+
+//! Default (-1) if file does not exist
+AbcArchivePool::FileVersion AbcArchivePool::fileVersion(const std::string& file)
+{
+	FileVersion version;
+	struct stat info;
+	if(stat(file.c_str(), &info) == 0)
+	{
+		version.modificationTime = (int64_t)info.st_mtim.tv_sec * 1000000000 + (int64_t)info.st_mtim.tv_nsec;
+		version.size = (int64_t)info.st_size;
+		version.inode = (uint64_t)info.st_ino;
+	}
+	return version;
+}
+
+AbcArchivePool& AbcArchivePool::defaultPool()
+{
+	static AbcArchivePool pool;
+	return pool;
+}
+
+std::shared_ptr<Alembic::Abc::IArchive> AbcArchivePool::acquire(const std::string& file)
+{
+	const FileVersion version = fileVersion(file);
+
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	std::shared_ptr<Entry>& entry = m_archives[file];
+
+	//a rewritten file gets a new archive, readers of the old one keep theirs
+	if(!entry || entry->version != version)
+	{
+		Alembic::AbcCoreFactory::IFactory factory;
+		factory.setPolicy(Alembic::Abc::ErrorHandler::kQuietNoopPolicy);
+		factory.setOgawaNumStreams(m_numStreams);
+		factory.setSampleCache(m_cache);
+		Alembic::AbcCoreFactory::IFactory::CoreType coreType;
+
+		std::shared_ptr<Alembic::Abc::IArchive> archive =
+			std::make_shared<Alembic::Abc::IArchive>(factory.getArchive(file, coreType));
+		if(!archive->valid())
+		{
+			m_archives.erase(file);
+			std::cout << "ERROR: Alembic Archive [" << file << "] could not be opened!" << std::endl;
+			return nullptr;
+		}
+
+		entry = std::make_shared<Entry>();
+		entry->archive = archive;
+		entry->version = version;
+		entry->users = 0;
+		entry->lastRelease = nowNanos();
+	}
+
+	//the handle shares the pool's archive and tells the entry when it goes away
+	std::shared_ptr<Entry> owner = entry;
+	++owner->users;
+	return std::shared_ptr<Alembic::Abc::IArchive>(owner->archive.get(), [owner](Alembic::Abc::IArchive*)
+	{
+		owner->lastRelease = nowNanos();
+		--owner->users;
+	});
+}
+
+void AbcArchivePool::setNumStreams(size_t numStreams)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_numStreams = std::max<size_t>(1, numStreams);
+}
+
+void AbcArchivePool::setIdleTimeout(double seconds)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		m_idleTimeout = seconds;
+	}
+	m_condition.notify_all();
+}
+
+void AbcArchivePool::closeIdle()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	closeIdle(0);
+}
+
+void AbcArchivePool::closeIdle(int64_t idleNanos)
+{
+	const int64_t now = nowNanos();
+	for(auto it = m_archives.begin(); it != m_archives.end();)
+	{
+		const Entry& entry = *it->second;
+		if(entry.users == 0 && now - entry.lastRelease >= idleNanos)
+		{
+			it = m_archives.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void AbcArchivePool::clear()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_archives.clear();
+}
+
+size_t AbcArchivePool::getNumOpen()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	return m_archives.size();
+}
+
+void AbcArchivePool::reap()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	while(!m_stop)
+	{
+		if(m_idleTimeout <= 0.0)
+		{
+			m_condition.wait(lock);
+			continue;
+		}
+
+		//checking twice per timeout closes an archive at most 1.5 timeouts after its last reader left
+		const int64_t idleNanos = (int64_t)(m_idleTimeout * 1e9);
+		m_condition.timed_wait(lock, boost::posix_time::microseconds(std::max<int64_t>(idleNanos / 2000, 1000)));
+		if(!m_stop && m_idleTimeout > 0.0)
+		{
+			closeIdle((int64_t)(m_idleTimeout * 1e9));
+		}
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <boost/thread.hpp>
+
+#include <Alembic/Abc/All.h>
+
+//! Process-wide cache of open input archives, so readers of the same file share one IArchive
+//! (and its file handles, parsed hierarchy and read cache) instead of opening it again each.
+//! Archives are keyed by path, modification time, size and inode, a file rewritten on disk is opened anew
+//! while readers of the old one keep it alive. Archives nobody holds are closed after an idle timeout.
+class AbcArchivePool
+{
+public:
+	AbcArchivePool();
+	//! Stops the idle reaper. Handed out archives stay valid.
+	~AbcArchivePool();
+
+	//! The archive of file, opened on first use. nullptr (and an error printed) if it cannot be opened.
+	std::shared_ptr<Alembic::Abc::IArchive> acquire(const std::string& file);
+
+	//! Ogawa streams of archives opened from now on, more streams let samples decode concurrently
+	void setNumStreams(size_t numStreams);
+	//! Close archives no reader has held for seconds (0 = keep them until closeIdle/clear)
+	void setIdleTimeout(double seconds);
+
+	//! Close every archive no reader holds right now, regardless of the timeout
+	void closeIdle();
+	//! Forget all archives. Handed out archives stay valid until their readers let go.
+	void clear();
+
+	//! Archives currently held open by the pool
+	size_t getNumOpen();
+
+	//! Pool shared by everything that does not ask for its own
+	static AbcArchivePool& defaultPool();
+
+private:
+	//! What tells a rewritten file apart from the one an archive was opened from
+	struct FileVersion
+	{
+		FileVersion() : modificationTime(-1), size(-1), inode(0) {}
+		bool operator==(const FileVersion& other) const
+		{
+			return modificationTime == other.modificationTime && size == other.size && inode == other.inode;
+		}
+		bool operator!=(const FileVersion& other) const { return !(*this == other); }
+
+		//nanoseconds, a file rewritten within the same second still differs in size or inode most of the time
+		int64_t modificationTime;
+		int64_t size;
+		uint64_t inode;
+	};
+
+	struct Entry
+	{
+		std::shared_ptr<Alembic::Abc::IArchive> archive;
+		FileVersion version;
+		//handed out handles still alive, and when the last one went away (steady clock nanoseconds)
+		std::atomic<int> users;
+		std::atomic<int64_t> lastRelease;
+	};
+
+	static FileVersion fileVersion(const std::string& file);
+	void closeIdle(int64_t idleNanos);
+	void reap();
+
+	boost::mutex m_mutex;
+	boost::condition_variable m_condition;
+	boost::thread m_reaper;
+	bool m_stop;
+
+	size_t m_numStreams;
+	double m_idleTimeout;
+	Alembic::AbcCoreAbstract::ReadArraySampleCachePtr m_cache;
+	std::unordered_map<std::string, std::shared_ptr<Entry>> m_archives;
+};
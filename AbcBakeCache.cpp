@@ -0,0 +1,449 @@
+#include "AbcBakeCache.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <exception>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "AbcReader.h"
+
+static const char BAKE_MAGIC[8] = {'E', 'A', 'B', 'C', 'B', 'A', 'K', 'E'};
+static const uint32_t BAKE_BYTE_ORDER = 0x01020304;
+static const uint32_t BAKE_VERSION = 1;
+static const uint64_t BAKE_ALIGNMENT = 64;
+//positions, faceIndices, faceCounts, normals
+static const uint32_t BAKE_FIXED_ARRAYS = 4;
+
+struct AbcBakeMapping
+{
+	boost::interprocess::file_mapping file;
+	boost::interprocess::mapped_region region;
+};
+
+static size_t elementSize(PROP_TYPE type)
+{
+	switch(type)
+	{
+	case FLOAT: return sizeof(float);
+	case VECTOR: return sizeof(Alembic::Abc::V3f);
+	case INT: return sizeof(int);
+	case VECTOR2: return sizeof(Alembic::Abc::V2f);
+	case QUAT: return sizeof(Alembic::Abc::Quatf);
+	default: return 0;
+	}
+}
+
+static uint64_t alignUp(uint64_t offset)
+{
+	return (offset + BAKE_ALIGNMENT - 1) / BAKE_ALIGNMENT * BAKE_ALIGNMENT;
+}
+
+static void pad(std::ofstream& out)
+{
+	static const char zeros[BAKE_ALIGNMENT] = {};
+	uint64_t offset = (uint64_t)out.tellp();
+	out.write(zeros, alignUp(offset) - offset);
+}
+
+template <typename T>
+static AbcBakeArray writeArray(std::ofstream& out, const AbcArrayView<T>& view)
+{
+	pad(out);
+	AbcBakeArray array;
+	array.offset = (uint64_t)out.tellp();
+	array.count = view.size();
+	out.write((const char*)view.data(), view.size() * sizeof(T));
+	return array;
+}
+
+//strings are not flat, they are not baked
+template <>
+AbcBakeArray writeArray<std::string>(std::ofstream&, const AbcArrayView<std::string>&)
+{
+	AbcBakeArray array = {0, 0};
+	return array;
+}
+
+template <typename T>
+static AbcBakeArray writeProperty(std::ofstream& out, const AbcSample& sample, int slot)
+{
+	const std::vector<AbcArrayView<T>>& properties = sample.getProperties<T>();
+	return writeArray(out, slot < (int)properties.size() ? properties[slot] : AbcArrayView<T>());
+}
+
+bool bakeArchive(AbcReader& reader, const std::string& bakeFile, int begin, int end)
+{
+	begin = std::max(begin, 0);
+	end = std::min(end, reader.getNumSamples());
+	if(begin >= end)
+	{
+		std::cout << "ERROR: No samples in range [" << begin << ", " << end << ") to bake." << std::endl;
+		return false;
+	}
+
+	//the cache holds one value per element
+	if(!reader.getExpandIndexedProperties())
+	{
+		std::cout << "ERROR: Indexed properties have to be expanded to bake [" << bakeFile << "]." << std::endl;
+		return false;
+	}
+
+	std::ofstream out(bakeFile.c_str(), std::ios::binary | std::ios::trunc);
+	if(!out)
+	{
+		std::cout << "ERROR: Bake cache [" << bakeFile << "] could not be created!" << std::endl;
+		return false;
+	}
+
+	//declared properties in type, then slot order
+	std::vector<std::pair<PROP_TYPE, std::string>> properties;
+	for(int type = 0; type < NUM_PROP_TYPES; ++type)
+	{
+		for(auto& name : reader.getPropertyNames((PROP_TYPE)type))
+		{
+			properties.push_back(std::make_pair((PROP_TYPE)type, name));
+		}
+	}
+
+	AbcBakeHeader header;
+	std::memcpy(header.magic, BAKE_MAGIC, sizeof(header.magic));
+	header.byteOrder = BAKE_BYTE_ORDER;
+	header.version = BAKE_VERSION;
+	header.firstSample = begin;
+	header.numSamples = end - begin;
+	header.numArrays = BAKE_FIXED_ARRAYS + properties.size();
+	header.numProperties = properties.size();
+	header.propertiesOffset = sizeof(AbcBakeHeader);
+	header.indexOffset = 0;
+	out.write((const char*)&header, sizeof(header));
+
+	std::vector<int> slots(NUM_PROP_TYPES, 0);
+	for(auto& p : properties)
+	{
+		uint32_t entry[3] = {(uint32_t)p.first, (uint32_t)slots[p.first]++, (uint32_t)p.second.size()};
+		out.write((const char*)entry, sizeof(entry));
+		out.write(p.second.data(), p.second.size());
+	}
+
+	std::vector<AbcBakeArray> index;
+	index.reserve((size_t)header.numSamples * header.numArrays);
+	AbcArrayView<int> lastFaceIndices;
+	AbcArrayView<int> lastFaceCounts;
+	AbcBakeArray lastFaceIndicesArray = {0, 0};
+	AbcBakeArray lastFaceCountsArray = {0, 0};
+
+	try
+	{
+		reader.readRange(begin, end, [&](const AbcSample& sample)
+		{
+			index.push_back(writeArray(out, sample.positions));
+
+			//the reader hands out unchanged topology as the same buffers, store it once
+			if(sample.faceIndices.data() != lastFaceIndices.data() || sample.faceIndices.size() != lastFaceIndices.size()
+				|| sample.faceCounts.data() != lastFaceCounts.data() || sample.faceCounts.size() != lastFaceCounts.size())
+			{
+				lastFaceIndices = sample.faceIndices;
+				lastFaceCounts = sample.faceCounts;
+				lastFaceIndicesArray = writeArray(out, sample.faceIndices);
+				lastFaceCountsArray = writeArray(out, sample.faceCounts);
+			}
+			index.push_back(lastFaceIndicesArray);
+			index.push_back(lastFaceCountsArray);
+
+			index.push_back(writeArray(out, sample.normals));
+
+			std::vector<int> propertySlots(NUM_PROP_TYPES, 0);
+			for(auto& p : properties)
+			{
+				int slot = propertySlots[p.first]++;
+				switch(p.first)
+				{
+				case FLOAT: index.push_back(writeProperty<float>(out, sample, slot)); break;
+				case VECTOR: index.push_back(writeProperty<Alembic::Abc::V3f>(out, sample, slot)); break;
+				case INT: index.push_back(writeProperty<int>(out, sample, slot)); break;
+				case VECTOR2: index.push_back(writeProperty<Alembic::Abc::V2f>(out, sample, slot)); break;
+				case QUAT: index.push_back(writeProperty<Alembic::Abc::Quatf>(out, sample, slot)); break;
+				default: index.push_back(writeProperty<std::string>(out, sample, slot)); break;
+				}
+			}
+		});
+	}
+	catch(std::exception& e)
+	{
+		std::cout << "ERROR: Baking [" << bakeFile << "] failed: " << e.what() << std::endl;
+		return false;
+	}
+
+	pad(out);
+	header.indexOffset = (uint64_t)out.tellp();
+	out.write((const char*)index.data(), index.size() * sizeof(AbcBakeArray));
+
+	//the index offset is only known now
+	out.seekp(0);
+	out.write((const char*)&header, sizeof(header));
+	out.close();
+
+	if(!out)
+	{
+		std::cout << "ERROR: Writing bake cache [" << bakeFile << "] failed!" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+AbcBakeReader::AbcBakeReader() : m_base(nullptr), m_index(nullptr)
+{
+	std::memset(&m_header, 0, sizeof(m_header));
+	m_numProperties.assign(NUM_PROP_TYPES, 0);
+}
+
+void AbcBakeReader::close()
+{
+	m_mapping.reset();
+	m_base = nullptr;
+	m_index = nullptr;
+	std::memset(&m_header, 0, sizeof(m_header));
+	m_properties.clear();
+	m_propertySlots.clear();
+	m_numProperties.assign(NUM_PROP_TYPES, 0);
+}
+
+bool AbcBakeReader::open(const std::string& file)
+{
+	close();
+
+	std::shared_ptr<AbcBakeMapping> mapping = std::make_shared<AbcBakeMapping>();
+	try
+	{
+		mapping->file = boost::interprocess::file_mapping(file.c_str(), boost::interprocess::read_only);
+		mapping->region = boost::interprocess::mapped_region(mapping->file, boost::interprocess::read_only);
+	}
+	catch(std::exception& e)
+	{
+		std::cout << "ERROR: Bake cache [" << file << "] could not be mapped: " << e.what() << std::endl;
+		return false;
+	}
+
+	const char* base = (const char*)mapping->region.get_address();
+	const uint64_t size = mapping->region.get_size();
+
+	AbcBakeHeader header;
+	if(size < sizeof(header))
+	{
+		std::cout << "ERROR: [" << file << "] is not a bake cache!" << std::endl;
+		return false;
+	}
+	std::memcpy(&header, base, sizeof(header));
+	if(std::memcmp(header.magic, BAKE_MAGIC, sizeof(header.magic)) != 0 || header.byteOrder != BAKE_BYTE_ORDER
+		|| header.version != BAKE_VERSION || header.numArrays != BAKE_FIXED_ARRAYS + header.numProperties)
+	{
+		std::cout << "ERROR: [" << file << "] is not a bake cache of this version and byte order!" << std::endl;
+		return false;
+	}
+
+	//property table
+	std::vector<size_t> elementSizes = {sizeof(Alembic::Abc::V3f), sizeof(int), sizeof(int), sizeof(Alembic::Abc::V3f)};
+	uint64_t offset = header.propertiesOffset;
+	for(uint32_t i = 0; i < header.numProperties; ++i)
+	{
+		uint32_t entry[3];
+		if(offset + sizeof(entry) > size)
+		{
+			std::cout << "ERROR: Bake cache [" << file << "] is truncated!" << std::endl;
+			close();
+			return false;
+		}
+		std::memcpy(entry, base + offset, sizeof(entry));
+		offset += sizeof(entry);
+		//a slot can be at most the number of properties, readSample allocates a view per slot
+		if(entry[0] >= NUM_PROP_TYPES || entry[1] >= header.numProperties || offset + entry[2] > size)
+		{
+			std::cout << "ERROR: Bake cache [" << file << "] has a corrupt property table!" << std::endl;
+			close();
+			return false;
+		}
+
+		PROP_TYPE type = (PROP_TYPE)entry[0];
+		int slot = (int)entry[1];
+		m_properties.push_back(std::make_pair(type, slot));
+		m_propertySlots.emplace(std::string(base + offset, entry[2]), std::make_pair(type, slot));
+		m_numProperties[type] = std::max(m_numProperties[type], (size_t)slot + 1);
+		elementSizes.push_back(elementSize(type));
+		offset += entry[2];
+	}
+
+	//every array has to lie inside the file, so readSample needs no checks
+	const uint64_t numEntries = (uint64_t)header.numSamples * header.numArrays;
+	if(header.indexOffset % alignof(AbcBakeArray) != 0 || header.indexOffset + numEntries * sizeof(AbcBakeArray) > size)
+	{
+		std::cout << "ERROR: Bake cache [" << file << "] is truncated!" << std::endl;
+		close();
+		return false;
+	}
+	const AbcBakeArray* index = (const AbcBakeArray*)(base + header.indexOffset);
+	for(uint64_t i = 0; i < numEntries; ++i)
+	{
+		const AbcBakeArray& array = index[i];
+		size_t bytes = elementSizes[i % header.numArrays];
+		//string slots are never baked, so they hold no elements
+		if(array.count > 0 && (bytes == 0 || array.offset % BAKE_ALIGNMENT != 0 || array.offset > size || array.count > (size - array.offset) / bytes))
+		{
+			std::cout << "ERROR: Bake cache [" << file << "] has a corrupt index!" << std::endl;
+			close();
+			return false;
+		}
+	}
+
+	m_mapping = mapping;
+	m_base = base;
+	m_header = header;
+	m_index = index;
+	return true;
+}
+
+template <typename T>
+AbcArrayView<T> AbcBakeReader::view(const AbcBakeArray& array) const
+{
+	if(array.count == 0)
+	{
+		return AbcArrayView<T>();
+	}
+	return AbcArrayView<T>((const T*)(m_base + array.offset), array.count, m_mapping);
+}
+
+template <typename T>
+static void resetProperties(AbcSample& sample, size_t count)
+{
+	sample.getProperties<T>().assign(count, AbcArrayView<T>());
+}
+
+bool AbcBakeReader::readSample(int sampleIdx, AbcSample& sample) const
+{
+	int localIdx = sampleIdx - m_header.firstSample;
+	if(!m_mapping || localIdx < 0 || localIdx >= (int)m_header.numSamples)
+	{
+		return false;
+	}
+
+	const AbcBakeArray* arrays = m_index + (size_t)localIdx * m_header.numArrays;
+	sample.index = sampleIdx;
+	sample.positions = view<Alembic::Abc::V3f>(arrays[0]);
+	sample.faceIndices = view<int>(arrays[1]);
+	sample.faceCounts = view<int>(arrays[2]);
+	sample.normals = view<Alembic::Abc::V3f>(arrays[3]);
+	sample.velocities = AbcArrayView<Alembic::Abc::V3f>();
+	sample.selfBounds = Alembic::Abc::Box3d();
+	sample.positionsSoA = AbcSoAVector3();
+	sample.normalsSoA = AbcSoAVector3();
+	sample.vectorPropertiesSoA.clear();
+	sample.propertyIndices.clear();
+
+	resetProperties<float>(sample, m_numProperties[FLOAT]);
+	resetProperties<Alembic::Abc::V3f>(sample, m_numProperties[VECTOR]);
+	resetProperties<int>(sample, m_numProperties[INT]);
+	resetProperties<Alembic::Abc::V2f>(sample, m_numProperties[VECTOR2]);
+	resetProperties<Alembic::Abc::Quatf>(sample, m_numProperties[QUAT]);
+	resetProperties<std::string>(sample, m_numProperties[STRING]);
+
+	for(size_t i = 0; i < m_properties.size(); ++i)
+	{
+		const AbcBakeArray& array = arrays[BAKE_FIXED_ARRAYS + i];
+		int slot = m_properties[i].second;
+		switch(m_properties[i].first)
+		{
+		case FLOAT: sample.floatProperties[slot] = view<float>(array); break;
+		case VECTOR: sample.vectorProperties[slot] = view<Alembic::Abc::V3f>(array); break;
+		case INT: sample.intProperties[slot] = view<int>(array); break;
+		case VECTOR2: sample.vector2Properties[slot] = view<Alembic::Abc::V2f>(array); break;
+		case QUAT: sample.quatProperties[slot] = view<Alembic::Abc::Quatf>(array); break;
+		default: break;
+		}
+	}
+
+	return true;
+}
+
+template <typename T>
+static bool sameArray(const AbcArrayView<T>& a, const AbcArrayView<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+template <typename T>
+static bool sameProperties(const AbcSample& a, const AbcSample& b)
+{
+	const std::vector<AbcArrayView<T>>& pa = a.getProperties<T>();
+	const std::vector<AbcArrayView<T>>& pb = b.getProperties<T>();
+	if(pa.size() != pb.size())
+	{
+		return false;
+	}
+	for(size_t i = 0; i < pa.size(); ++i)
+	{
+		if(!sameArray(pa[i], pb[i]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool validateBake(AbcReader& reader, const AbcBakeReader& bake)
+{
+	if(!bake.isOpen())
+	{
+		std::cout << "ERROR: Bake cache is not open!" << std::endl;
+		return false;
+	}
+	if(!reader.getExpandIndexedProperties())
+	{
+		std::cout << "ERROR: Indexed properties have to be expanded to validate a bake cache." << std::endl;
+		return false;
+	}
+
+	int mismatches = 0;
+	const int begin = bake.getFirstSample();
+	const int end = begin + bake.getNumSamples();
+	if(end > reader.getNumSamples())
+	{
+		std::cout << "ERROR: Bake cache holds samples up to " << end << ", the archive only " << reader.getNumSamples() << std::endl;
+		return false;
+	}
+
+	try
+	{
+		reader.readRange(begin, end, [&](const AbcSample& decoded)
+		{
+			AbcSample baked;
+			bake.readSample(decoded.index, baked);
+
+			const char* mismatch = nullptr;
+			if(!sameArray(decoded.positions, baked.positions)) mismatch = "positions";
+			else if(!sameArray(decoded.faceIndices, baked.faceIndices)) mismatch = "faceIndices";
+			else if(!sameArray(decoded.faceCounts, baked.faceCounts)) mismatch = "faceCounts";
+			else if(!sameArray(decoded.normals, baked.normals)) mismatch = "normals";
+			else if(!sameProperties<float>(decoded, baked)) mismatch = "float properties";
+			else if(!sameProperties<Alembic::Abc::V3f>(decoded, baked)) mismatch = "vector properties";
+			else if(!sameProperties<int>(decoded, baked)) mismatch = "int properties";
+			else if(!sameProperties<Alembic::Abc::V2f>(decoded, baked)) mismatch = "vector2 properties";
+			else if(!sameProperties<Alembic::Abc::Quatf>(decoded, baked)) mismatch = "quat properties";
+
+			if(mismatch)
+			{
+				std::cout << "ERROR: Bake cache differs from the archive in sample " << decoded.index << " (" << mismatch << ")" << std::endl;
+				++mismatches;
+			}
+		});
+	}
+	catch(std::exception& e)
+	{
+		std::cout << "ERROR: Validating the bake cache failed: " << e.what() << std::endl;
+		return false;
+	}
+
+	return mismatches == 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+#include "easyAbcUtil.h"
+#include "AbcSample.h"
+#include "AbcProperty.h"
+
+class AbcReader;
+struct AbcBakeMapping;
+
+//Bake cache file layout (native byte order, every array 64 byte aligned):
+//  AbcBakeHeader
+//  property table: per declared property {uint32 type, uint32 slot, uint32 nameLength, name}
+//  sample data: per sample positions, faceIndices, faceCounts, normals, then the properties in table order,
+//               each attribute in its own contiguous array. Unchanged topology is stored once and shared.
+//  index: numSamples * numArrays AbcBakeArray {offset, count}
+
+struct AbcBakeHeader
+{
+	char magic[8];
+	uint32_t byteOrder;
+	uint32_t version;
+	int32_t firstSample;
+	uint32_t numSamples;
+	uint32_t numArrays;
+	uint32_t numProperties;
+	uint64_t propertiesOffset;
+	uint64_t indexOffset;
+};
+
+struct AbcBakeArray
+{
+	uint64_t offset;
+	uint64_t count;
+};
+
+//! Memory-mapped reader for bake caches written by bakeArchive.
+//! Opening only checks the header and index, samples are views straight into the mapping.
+class AbcBakeReader
+{
+public:
+	AbcBakeReader();
+
+	bool open(const std::string& file);
+	//! Samples handed out earlier keep the mapping alive
+	void close();
+	bool isOpen() const { return m_mapping != nullptr; }
+
+	//! Sample indices are those of the source archive, starting at getFirstSample
+	int getFirstSample() const { return m_header.firstSample; }
+	int getNumSamples() const { return m_header.numSamples; }
+
+	//! Zero-copy views of one sample. String properties, velocities and selfBounds are not baked and stay empty.
+	bool readSample(int sampleIdx, AbcSample& sample) const;
+
+	//! Same slots as the AbcReader the cache was baked from, use with sample.getProperties<T>()
+	template <typename T>
+	AbcPropertyHandle<T> getPropertyHandle(const std::string& name) const
+	{
+		auto it = m_propertySlots.find(name);
+		if(it == m_propertySlots.end() || it->second.first != AbcPropertyTraits<T>::type)
+		{
+			return AbcPropertyHandle<T>();
+		}
+		return AbcPropertyHandle<T>(it->second.second);
+	}
+
+private:
+	template <typename T>
+	AbcArrayView<T> view(const AbcBakeArray& array) const;
+
+	std::shared_ptr<AbcBakeMapping> m_mapping;
+	const char* m_base;
+	AbcBakeHeader m_header;
+	const AbcBakeArray* m_index;
+
+	//table order: (type, slot)
+	std::vector<std::pair<PROP_TYPE, int>> m_properties;
+	std::unordered_map<std::string, std::pair<PROP_TYPE, int>> m_propertySlots;
+	std::vector<size_t> m_numProperties;
+};
+
+//! Write samples [begin, end) as decoded by reader (with its declared properties) to a bake cache.
+//! Samples are decoded in parallel through AbcReader::readRange.
+bool bakeArchive(AbcReader& reader, const std::string& bakeFile, int begin, int end);
+
+//! Decode every baked sample again through reader and compare it bit for bit. Prints each mismatch.
+bool validateBake(AbcReader& reader, const AbcBakeReader& bake);
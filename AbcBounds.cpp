@@ -0,0 +1,139 @@
+#include "AbcBounds.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "AbcThreadPool.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define EASYABC_SSE 1
+#endif
+
+//below this many points one thread is faster than handing out chunks
+static const size_t PARALLEL_BOUNDS_THRESHOLD = 1 << 18;
+
+struct AbcMinMax
+{
+	float min[3];
+	float max[3];
+};
+
+static AbcMinMax emptyMinMax()
+{
+	AbcMinMax m;
+	for(int i = 0; i < 3; ++i)
+	{
+		m.min[i] = std::numeric_limits<float>::max();
+		m.max[i] = -std::numeric_limits<float>::max();
+	}
+	return m;
+}
+
+static void extend(AbcMinMax& m, const AbcMinMax& other)
+{
+	for(int i = 0; i < 3; ++i)
+	{
+		m.min[i] = std::min(m.min[i], other.min[i]);
+		m.max[i] = std::max(m.max[i], other.max[i]);
+	}
+}
+
+static AbcMinMax minMax(const float* src, size_t count)
+{
+	AbcMinMax m = emptyMinMax();
+	size_t i = 0;
+
+#ifdef EASYABC_SSE
+	if(count >= 4)
+	{
+		//lanes of a = x y z x, b = y z x y, c = z x y z
+		__m128 minA = _mm_loadu_ps(src), maxA = minA;
+		__m128 minB = _mm_loadu_ps(src + 4), maxB = minB;
+		__m128 minC = _mm_loadu_ps(src + 8), maxC = minC;
+		for(i = 4; i + 4 <= count; i += 4)
+		{
+			const float* block = src + i * 3;
+			__m128 a = _mm_loadu_ps(block);
+			__m128 b = _mm_loadu_ps(block + 4);
+			__m128 c = _mm_loadu_ps(block + 8);
+			minA = _mm_min_ps(minA, a);
+			maxA = _mm_max_ps(maxA, a);
+			minB = _mm_min_ps(minB, b);
+			maxB = _mm_max_ps(maxB, b);
+			minC = _mm_min_ps(minC, c);
+			maxC = _mm_max_ps(maxC, c);
+		}
+
+		float lo[12];
+		float hi[12];
+		_mm_storeu_ps(lo, minA);
+		_mm_storeu_ps(lo + 4, minB);
+		_mm_storeu_ps(lo + 8, minC);
+		_mm_storeu_ps(hi, maxA);
+		_mm_storeu_ps(hi + 4, maxB);
+		_mm_storeu_ps(hi + 8, maxC);
+		//lane j of the 12 holds component j % 3
+		for(int j = 0; j < 12; ++j)
+		{
+			m.min[j % 3] = std::min(m.min[j % 3], lo[j]);
+			m.max[j % 3] = std::max(m.max[j % 3], hi[j]);
+		}
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		for(int j = 0; j < 3; ++j)
+		{
+			m.min[j] = std::min(m.min[j], src[i * 3 + j]);
+			m.max[j] = std::max(m.max[j], src[i * 3 + j]);
+		}
+	}
+	return m;
+}
+
+Alembic::Abc::Box3d computeBounds(const Alembic::Abc::V3f* points, size_t count)
+{
+	if(count == 0)
+	{
+		return Alembic::Abc::Box3d();
+	}
+
+	const float* src = (const float*)points;
+	AbcMinMax m;
+	if(count < PARALLEL_BOUNDS_THRESHOLD)
+	{
+		m = minMax(src, count);
+	}
+	else
+	{
+		AbcThreadPool& pool = AbcThreadPool::defaultPool();
+		const size_t numChunks = std::min(pool.getNumThreads() * 4, count / (PARALLEL_BOUNDS_THRESHOLD / 4));
+		const size_t chunkSize = (count + numChunks - 1) / numChunks;
+		std::vector<AbcMinMax> partial(numChunks, emptyMinMax());
+		pool.parallelFor(numChunks, [&](size_t chunk)
+		{
+			size_t begin = chunk * chunkSize;
+			size_t end = std::min(begin + chunkSize, count);
+			if(begin < end)
+			{
+				partial[chunk] = minMax(src + begin * 3, end - begin);
+			}
+		});
+
+		m = emptyMinMax();
+		for(auto& p : partial)
+		{
+			extend(m, p);
+		}
+	}
+
+	return Alembic::Abc::Box3d(Alembic::Abc::V3d(m.min[0], m.min[1], m.min[2]), Alembic::Abc::V3d(m.max[0], m.max[1], m.max[2]));
+}
+
+Alembic::Abc::Box3d computeBounds(const AbcArrayView<Alembic::Abc::V3f>& points)
+{
+	return computeBounds(points.data(), points.size());
+}
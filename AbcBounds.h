@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Alembic/Abc/All.h>
+
+#include "AbcSample.h"
+
+//! Axis aligned bounds of count points, empty for none.
+//! SSE min/max over 4 points per step, split over the default thread pool for large meshes.
+Alembic::Abc::Box3d computeBounds(const Alembic::Abc::V3f* points, size_t count);
+Alembic::Abc::Box3d computeBounds(const AbcArrayView<Alembic::Abc::V3f>& points);
@@ -0,0 +1,58 @@
+#include "AbcIndexing.h"
+
+#include <algorithm>
+#include <cstring>
+
+static uint32_t hashBits(const uint32_t* bits)
+{
+	uint32_t h = bits[0] * 0x9E3779B1u ^ bits[1] * 0x85EBCA77u ^ bits[2] * 0xC2B2AE3Du;
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 13;
+	return h;
+}
+
+bool indexValues(const Alembic::Abc::V3f* values, size_t count, size_t maxUnique,
+	std::vector<Alembic::Abc::V3f>& unique, std::vector<uint32_t>& indices)
+{
+	unique.clear();
+	indices.resize(count);
+	if(count == 0)
+	{
+		return true;
+	}
+
+	//at most half full, slots hold the unique index + 1
+	const size_t capacity = std::min(maxUnique, count) + 1;
+	size_t tableSize = 16;
+	while(tableSize < capacity * 2)
+	{
+		tableSize *= 2;
+	}
+	const size_t mask = tableSize - 1;
+	std::vector<uint32_t> table(tableSize, 0);
+
+	for(size_t i = 0; i < count; ++i)
+	{
+		uint32_t bits[3];
+		std::memcpy(bits, &values[i], sizeof(bits));
+
+		size_t slot = hashBits(bits) & mask;
+		while(table[slot] != 0 && std::memcmp(&unique[table[slot] - 1], bits, sizeof(bits)) != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		if(table[slot] == 0)
+		{
+			if(unique.size() == maxUnique)
+			{
+				return false;
+			}
+			unique.push_back(values[i]);
+			table[slot] = (uint32_t)unique.size();
+		}
+		indices[i] = table[slot] - 1;
+	}
+	return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <Alembic/Abc/All.h>
+
+//! Splits count values into their unique values (compared bit for bit, in order of first occurrence) and
+//! one index per value into them, for indexed GeomParams. Open addressing hash table, one pass.
+//! Gives up and returns false as soon as there are more than maxUnique distinct values.
+bool indexValues(const Alembic::Abc::V3f* values, size_t count, size_t maxUnique,
+	std::vector<Alembic::Abc::V3f>& unique, std::vector<uint32_t>& indices);
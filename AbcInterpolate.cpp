@@ -0,0 +1,56 @@
+#include "AbcInterpolate.h"
+
+#include "AbcThreadPool.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define EASYABC_SSE 1
+#endif
+
+//floats per task, small meshes stay on the calling thread
+static const size_t INTERPOLATE_CHUNK_SIZE = 1 << 18;
+
+//! out = a + d * s for count floats, d = b - a if SUBTRACT, b otherwise
+template <bool SUBTRACT>
+static void blend(const float* a, const float* b, float s, size_t count, float* out)
+{
+	size_t i = 0;
+
+#ifdef EASYABC_SSE
+	const __m128 vs = _mm_set1_ps(s);
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128 va = _mm_loadu_ps(a + i);
+		__m128 vd = _mm_loadu_ps(b + i);
+		if(SUBTRACT)
+		{
+			vd = _mm_sub_ps(vd, va);
+		}
+		_mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(vd, vs)));
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		out[i] = a[i] + (SUBTRACT ? b[i] - a[i] : b[i]) * s;
+	}
+}
+
+template <bool SUBTRACT>
+static void parallelBlend(const float* a, const float* b, float s, size_t count, float* out)
+{
+	AbcThreadPool::defaultPool().parallelForChunks(count, INTERPOLATE_CHUNK_SIZE, [&](size_t begin, size_t end)
+	{
+		blend<SUBTRACT>(a + begin, b + begin, s, end - begin, out + begin);
+	});
+}
+
+void lerpPoints(const Alembic::Abc::V3f* a, const Alembic::Abc::V3f* b, float t, size_t count, Alembic::Abc::V3f* out)
+{
+	parallelBlend<true>((const float*)a, (const float*)b, t, count * 3, (float*)out);
+}
+
+void advectPoints(const Alembic::Abc::V3f* p, const Alembic::Abc::V3f* v, float dt, size_t count, Alembic::Abc::V3f* out)
+{
+	parallelBlend<false>((const float*)p, (const float*)v, dt, count * 3, (float*)out);
+}
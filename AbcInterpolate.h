@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Alembic/Abc/All.h>
+
+//Position interpolation for sub-frame sampling. SSE over the flat x, y, z stream,
+//split over the default thread pool for large meshes. out may alias the inputs.
+
+//! out = a + (b - a) * t
+void lerpPoints(const Alembic::Abc::V3f* a, const Alembic::Abc::V3f* b, float t, size_t count, Alembic::Abc::V3f* out);
+
+//! out = p + v * dt, velocities in units per second and dt in seconds
+void advectPoints(const Alembic::Abc::V3f* p, const Alembic::Abc::V3f* v, float dt, size_t count, Alembic::Abc::V3f* out);
@@ -0,0 +1,119 @@
+#include "AbcMerge.h"
+
+#include <iostream>
+#include <memory>
+
+#include <Alembic/AbcCoreFactory/All.h>
+
+#include "AbcReader.h"
+#include "AbcWriter.h"
+#include "AbcThreadPool.h"
+
+//! One decoded frame file. The reader holds the archive and every buffer the sample views point into.
+struct AbcMergeFrame
+{
+	AbcMergeFrame() : ok(false), hasXForm(false) {}
+
+	bool ok;
+	std::shared_ptr<AbcReader> reader;
+	bool hasXForm;
+	Alembic::Abc::M44d xForm;
+};
+
+static void loadFrame(const std::string& file, const std::string& xFormName, const std::string& meshName,
+	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& properties, AbcMergeFrame& frame)
+{
+	//every frame is read once, no point sharing or caching its archive
+	Alembic::AbcCoreFactory::IFactory factory;
+	factory.setPolicy(Alembic::Abc::ErrorHandler::kQuietNoopPolicy);
+	Alembic::AbcCoreFactory::IFactory::CoreType coreType;
+	std::shared_ptr<Alembic::Abc::IArchive> archive =
+		std::make_shared<Alembic::Abc::IArchive>(factory.getArchive(file, coreType));
+	if(!archive->valid())
+	{
+		std::cout << "ERROR: Alembic Archive [" << file << "] could not be opened!" << std::endl;
+		return;
+	}
+
+	//decodes the first sample
+	frame.reader = std::make_shared<AbcReader>();
+	if(!frame.reader->openArchive(archive, xFormName, meshName, properties) || frame.reader->getNumSamples() == 0)
+	{
+		std::cout << "ERROR: Frame [" << file << "] has no sample of " << meshName << "." << std::endl;
+		return;
+	}
+
+	Alembic::Abc::IObject xFormObject = archive->getTop().getChild(xFormName);
+	if(xFormObject.valid() && Alembic::AbcGeom::IXform::matches(xFormObject.getMetaData()))
+	{
+		Alembic::AbcGeom::IXform xForm(xFormObject, Alembic::AbcGeom::kWrapExisting);
+		if(xForm.getSchema().getNumSamples() > 0)
+		{
+			Alembic::AbcGeom::XformSample sample;
+			xForm.getSchema().get(sample, Alembic::Abc::ISampleSelector((Alembic::Abc::index_t)0));
+			frame.xForm = sample.getMatrix();
+			frame.hasXForm = true;
+		}
+	}
+	frame.ok = true;
+}
+
+static bool writeFrame(AbcWriter& writer, const AbcMergeFrame& frame)
+{
+	if(frame.hasXForm)
+	{
+		writer.addXFormSample(frame.xForm);
+	}
+	//reader and writer were given the same list, so their slots match
+	return writer.addSample(writer.createSample(frame.reader->getSample()));
+}
+
+bool mergeArchives(const std::vector<std::string>& frameFiles, const std::string& outFile,
+	const std::string& xFormName, const std::string& meshName,
+	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties, size_t prefetch)
+{
+	if(frameFiles.empty())
+	{
+		std::cout << "ERROR: No frames to merge into [" << outFile << "]." << std::endl;
+		return false;
+	}
+
+	std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> properties;
+	for(auto& p : arbGeoProperties)
+	{
+		if(std::get<1>(p) == FLOAT || std::get<1>(p) == VECTOR)
+		{
+			properties.push_back(p);
+		}
+		else
+		{
+			std::cout << "WARNING: Only FLOAT and VECTOR properties can be merged, leaving out " << std::get<0>(p) << "." << std::endl;
+		}
+	}
+
+	AbcWriter writer(outFile, xFormName, meshName, properties);
+
+	//frames are written in order on this thread while the workers decode ahead
+	bool ok = true;
+	size_t lastFrame = 0;
+	AbcThreadPool::defaultPool().orderedPrefetch<AbcMergeFrame>(frameFiles.size(), prefetch,
+		[&](size_t frameIdx, AbcMergeFrame& frame)
+		{
+			loadFrame(frameFiles[frameIdx], xFormName, meshName, properties, frame);
+		},
+		[&](size_t frameIdx, AbcMergeFrame& frame)
+		{
+			lastFrame = frameIdx;
+			ok = frame.ok && writeFrame(writer, frame);
+			//closes the frame's archive
+			frame = AbcMergeFrame();
+			return ok;
+		});
+
+	if(!ok)
+	{
+		std::cout << "ERROR: Merging frame " << lastFrame << " [" << frameFiles[lastFrame] << "] into [" << outFile << "] failed." << std::endl;
+		return false;
+	}
+	return writer.flush();
+}
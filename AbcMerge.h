@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <tuple>
+
+#include "easyAbcUtil.h"
+
+//! Write the mesh xFormName/meshName of every per-frame archive in frameFiles, in the given order, as the samples
+//! of one animated archive (the first sample of each file, with its transform). Up to prefetch upcoming files are
+//! opened and decoded concurrently on the default thread pool (0 = two per worker) while the samples are written on
+//! the calling thread. Decoded buffers go to the writer as they are, a frame with the topology of the one before
+//! only references it. Only FLOAT and VECTOR properties can be merged, the others are left out with a warning.
+bool mergeArchives(const std::vector<std::string>& frameFiles, const std::string& outFile,
+	const std::string& xFormName, const std::string& meshName,
+	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties, size_t prefetch = 0);
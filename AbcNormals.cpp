@@ -0,0 +1,164 @@
+#include "AbcNormals.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+#include "AbcThreadPool.h"
+
+//items per task, small meshes stay on the calling thread
+static const size_t NORMALS_CHUNK_SIZE = 1 << 14;
+
+static void normalize(Alembic::Abc::V3f& n)
+{
+	float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+	if(length > 0.0f)
+	{
+		n.x /= length;
+		n.y /= length;
+		n.z /= length;
+	}
+}
+
+std::shared_ptr<const AbcMeshAdjacency> AbcNormalGenerator::getAdjacency(size_t numPoints,
+	const AbcArrayView<int>& faceIndices, const AbcArrayView<int>& faceCounts)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		if(m_adjacency && m_adjacency->numPoints == numPoints
+			&& sameContents(m_adjacency->faceCounts, faceCounts) && sameContents(m_adjacency->faceIndices, faceIndices))
+		{
+			return m_adjacency;
+		}
+	}
+
+	std::shared_ptr<AbcMeshAdjacency> adjacency = std::make_shared<AbcMeshAdjacency>();
+	adjacency->numPoints = numPoints;
+	//the caller's buffers may be refilled, keep our own copy unless they are shared
+	adjacency->faceIndices = faceIndices.owner() ? faceIndices : AbcArrayView<int>::adopt(faceIndices.toVector());
+	adjacency->faceCounts = faceCounts.owner() ? faceCounts : AbcArrayView<int>::adopt(faceCounts.toVector());
+
+	adjacency->faceOffsets.resize(faceCounts.size() + 1);
+	adjacency->faceOffsets[0] = 0;
+	for(size_t f = 0; f < faceCounts.size(); ++f)
+	{
+		if(faceCounts[f] < 0)
+		{
+			return nullptr;
+		}
+		adjacency->faceOffsets[f + 1] = adjacency->faceOffsets[f] + faceCounts[f];
+	}
+	if((size_t)adjacency->faceOffsets.back() != faceIndices.size())
+	{
+		return nullptr;
+	}
+
+	//counting sort of the corners by point
+	adjacency->pointFaceOffsets.assign(numPoints + 1, 0);
+	for(int idx : faceIndices)
+	{
+		if(idx < 0 || (size_t)idx >= numPoints)
+		{
+			return nullptr;
+		}
+		++adjacency->pointFaceOffsets[idx + 1];
+	}
+	for(size_t p = 0; p < numPoints; ++p)
+	{
+		adjacency->pointFaceOffsets[p + 1] += adjacency->pointFaceOffsets[p];
+	}
+
+	adjacency->pointFaces.resize(faceIndices.size());
+	std::vector<int> fill(adjacency->pointFaceOffsets.begin(), adjacency->pointFaceOffsets.end() - 1);
+	for(size_t f = 0; f < faceCounts.size(); ++f)
+	{
+		for(int c = adjacency->faceOffsets[f]; c < adjacency->faceOffsets[f + 1]; ++c)
+		{
+			adjacency->pointFaces[fill[faceIndices[c]]++] = (int)f;
+		}
+	}
+
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_adjacency = adjacency;
+	return adjacency;
+}
+
+AbcArrayView<Alembic::Abc::V3f> AbcNormalGenerator::compute(const AbcArrayView<Alembic::Abc::V3f>& positions,
+	const AbcArrayView<int>& faceIndices, const AbcArrayView<int>& faceCounts, PROP_SCOPE scope)
+{
+	std::shared_ptr<const AbcMeshAdjacency> adjacency = getAdjacency(positions.size(), faceIndices, faceCounts);
+	if(!adjacency)
+	{
+		std::cout << "ERROR: Face indices do not match the positions, normals cannot be generated." << std::endl;
+		return AbcArrayView<Alembic::Abc::V3f>();
+	}
+
+	const Alembic::Abc::V3f* P = positions.data();
+	const int* indices = faceIndices.data();
+	const int* faceOffsets = adjacency->faceOffsets.data();
+	const size_t numFaces = faceCounts.size();
+
+	//FACE NORMALS -----------------------------------------------------------------
+	//Newell's method, the length is twice the polygon area so summing them weights by area.
+	//Alembic winds polygons clockwise, hence the flipped sign.
+	std::vector<Alembic::Abc::V3f> faceNormals(numFaces);
+	AbcThreadPool::defaultPool().parallelForChunks(numFaces, NORMALS_CHUNK_SIZE, [&](size_t begin, size_t end)
+	{
+		for(size_t f = begin; f < end; ++f)
+		{
+			float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+			const int first = faceOffsets[f];
+			const int count = faceOffsets[f + 1] - first;
+			for(int c = 0; c < count; ++c)
+			{
+				const Alembic::Abc::V3f& cur = P[indices[first + c]];
+				const Alembic::Abc::V3f& next = P[indices[first + (c + 1 == count ? 0 : c + 1)]];
+				nx += (cur.y - next.y) * (cur.z + next.z);
+				ny += (cur.z - next.z) * (cur.x + next.x);
+				nz += (cur.x - next.x) * (cur.y + next.y);
+			}
+			faceNormals[f] = Alembic::Abc::V3f(-nx, -ny, -nz);
+		}
+	});
+
+	if(scope == FACE)
+	{
+		//facevarying: every corner gets the flat normal of its face
+		std::vector<Alembic::Abc::V3f> cornerNormals(faceIndices.size());
+		AbcThreadPool::defaultPool().parallelForChunks(numFaces, NORMALS_CHUNK_SIZE, [&](size_t begin, size_t end)
+		{
+			for(size_t f = begin; f < end; ++f)
+			{
+				Alembic::Abc::V3f n = faceNormals[f];
+				normalize(n);
+				std::fill(cornerNormals.begin() + faceOffsets[f], cornerNormals.begin() + faceOffsets[f + 1], n);
+			}
+		});
+		return AbcArrayView<Alembic::Abc::V3f>::adopt(std::move(cornerNormals));
+	}
+
+	//POINT NORMALS ----------------------------------------------------------------
+	//POINT and VERTEX scope both hold one normal per point in alembic, smooth
+	//gathered per point, so no two tasks ever write the same normal
+	const int* pointFaceOffsets = adjacency->pointFaceOffsets.data();
+	const int* pointFaces = adjacency->pointFaces.data();
+	std::vector<Alembic::Abc::V3f> pointNormals(positions.size());
+	AbcThreadPool::defaultPool().parallelForChunks(positions.size(), NORMALS_CHUNK_SIZE, [&](size_t begin, size_t end)
+	{
+		for(size_t p = begin; p < end; ++p)
+		{
+			float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+			for(int i = pointFaceOffsets[p]; i < pointFaceOffsets[p + 1]; ++i)
+			{
+				const Alembic::Abc::V3f& n = faceNormals[pointFaces[i]];
+				nx += n.x;
+				ny += n.y;
+				nz += n.z;
+			}
+			pointNormals[p] = Alembic::Abc::V3f(nx, ny, nz);
+			normalize(pointNormals[p]);
+		}
+	});
+
+	return AbcArrayView<Alembic::Abc::V3f>::adopt(std::move(pointNormals));
+}
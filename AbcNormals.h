@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include <Alembic/Abc/All.h>
+
+#include "easyAbcUtil.h"
+#include "AbcSample.h"
+
+//! Face offsets and point-to-face incidence of one topology
+struct AbcMeshAdjacency
+{
+	//the topology this was built from, compared against the next sample's
+	AbcArrayView<int> faceIndices;
+	AbcArrayView<int> faceCounts;
+	size_t numPoints;
+
+	//first corner of every face, numFaces + 1 entries
+	std::vector<int> faceOffsets;
+	//faces around point p are pointFaces[pointFaceOffsets[p] .. pointFaceOffsets[p + 1])
+	std::vector<int> pointFaceOffsets;
+	std::vector<int> pointFaces;
+};
+
+//! Generates area weighted normals on the default thread pool.
+//! The adjacency is built once and reused as long as the topology does not change. Safe to call from several threads.
+class AbcNormalGenerator
+{
+public:
+	//! Sized for the alembic scope AbcWriter stores each PROP_SCOPE with: POINT and VERTEX one smooth normal
+	//! per point, FACE (facevarying) one per face corner, the flat normal of its face.
+	//! Returns an empty array if faceIndices reference points that do not exist.
+	AbcArrayView<Alembic::Abc::V3f> compute(const AbcArrayView<Alembic::Abc::V3f>& positions,
+		const AbcArrayView<int>& faceIndices, const AbcArrayView<int>& faceCounts, PROP_SCOPE scope);
+
+private:
+	std::shared_ptr<const AbcMeshAdjacency> getAdjacency(size_t numPoints,
+		const AbcArrayView<int>& faceIndices, const AbcArrayView<int>& faceCounts);
+
+	boost::mutex m_mutex;
+	std::shared_ptr<const AbcMeshAdjacency> m_adjacency;
+};
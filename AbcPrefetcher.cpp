@@ -0,0 +1,139 @@
+#include "AbcPrefetcher.h"
+
+#include <iostream>
+
+AbcPrefetcher::AbcPrefetcher(const DecodeFunction& decode, int depth) : m_decode(decode), m_depth(depth),
+	m_numSamples(0), m_stop(false), m_generation(0), m_direction(0), m_head(-1), m_nextToDecode(-1), m_busy(false)
+{
+	m_thread = boost::thread(&AbcPrefetcher::run, this);
+}
+
+AbcPrefetcher::~AbcPrefetcher()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+}
+
+void AbcPrefetcher::setDepth(int depth)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_depth = depth;
+	m_condition.notify_all();
+}
+
+int AbcPrefetcher::getDepth()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	return m_depth;
+}
+
+void AbcPrefetcher::start(int currentSample, int direction, int numSamples)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	++m_generation;
+	m_ready.clear();
+	m_numSamples = numSamples;
+	m_direction = direction;
+	m_head = currentSample + direction;
+	m_nextToDecode = m_head;
+	m_condition.notify_all();
+}
+
+void AbcPrefetcher::cancel(bool waitForWorker)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	++m_generation;
+	m_ready.clear();
+	m_direction = 0;
+	m_condition.notify_all();
+
+	while(waitForWorker && m_busy)
+	{
+		m_condition.wait(lock);
+	}
+}
+
+bool AbcPrefetcher::take(int sampleIdx, int direction, AbcSample& sample)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	if(m_direction == 0 || m_direction != direction || sampleIdx != m_head
+		|| sampleIdx < 0 || sampleIdx >= m_numSamples || m_depth <= 0)
+	{
+		return false;
+	}
+
+	while(m_ready.empty() && m_direction != 0)
+	{
+		m_condition.wait(lock);
+	}
+
+	//the worker gave up on this run, let the caller decode it itself
+	if(m_ready.empty())
+	{
+		return false;
+	}
+
+	std::swap(sample, m_ready.front());
+	m_ready.pop_front();
+	m_head += m_direction;
+
+	//a slot became free, let the worker carry on
+	m_condition.notify_all();
+	return true;
+}
+
+void AbcPrefetcher::run()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	while(true)
+	{
+		while(!m_stop && (m_direction == 0 || (int)m_ready.size() >= m_depth
+			|| m_nextToDecode < 0 || m_nextToDecode >= m_numSamples))
+		{
+			m_condition.wait(lock);
+		}
+
+		if(m_stop)
+		{
+			break;
+		}
+
+		int sampleIdx = m_nextToDecode;
+		unsigned generation = m_generation;
+		m_nextToDecode += m_direction;
+		m_busy = true;
+
+		//decode without holding the lock so the caller can keep taking samples
+		lock.unlock();
+		AbcSample sample;
+		bool decoded = true;
+		try
+		{
+			m_decode(sampleIdx, sample);
+		}
+		catch(std::exception& e)
+		{
+			std::cout << "ERROR: Prefetching sample " << sampleIdx << " failed: " << e.what() << std::endl;
+			decoded = false;
+		}
+		lock.lock();
+
+		m_busy = false;
+		if(generation == m_generation)
+		{
+			if(decoded)
+			{
+				m_ready.push_back(std::move(sample));
+			}
+			else
+			{
+				m_direction = 0;
+			}
+		}
+		m_condition.notify_all();
+	}
+}
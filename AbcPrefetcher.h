@@ -0,0 +1,53 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+
+#include <boost/thread.hpp>
+
+#include "AbcSample.h"
+
+//! Decodes the samples following the current one on a worker thread,
+//! so stepping through an archive becomes a buffer swap.
+class AbcPrefetcher
+{
+public:
+	typedef std::function<void(int, AbcSample&)> DecodeFunction;
+
+	AbcPrefetcher(const DecodeFunction& decode, int depth);
+	~AbcPrefetcher();
+
+	//! Maximum number of decoded samples kept ahead of the caller
+	void setDepth(int depth);
+	int getDepth();
+
+	//! Start decoding the samples after currentSample in direction (+1 forward, -1 backward)
+	void start(int currentSample, int direction, int numSamples);
+
+	//! Drop all queued samples. With waitForWorker the call blocks until no decode is in flight.
+	void cancel(bool waitForWorker = false);
+
+	//! Swap the prefetched sampleIdx into sample, blocking until it is decoded.
+	//! Returns false if sampleIdx is not the next sample queued in that direction.
+	bool take(int sampleIdx, int direction, AbcSample& sample);
+
+private:
+	void run();
+
+	DecodeFunction m_decode;
+	int m_depth;
+	int m_numSamples;
+
+	boost::mutex m_mutex;
+	boost::condition_variable m_condition;
+	boost::thread m_thread;
+	bool m_stop;
+
+	//bumped on every start/cancel so results of stale decodes get discarded
+	unsigned m_generation;
+	int m_direction;
+	int m_head;
+	int m_nextToDecode;
+	bool m_busy;
+	std::deque<AbcSample> m_ready;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <tuple>
+
+#include <Alembic/Abc/All.h>
+
+#include "easyAbcUtil.h"
+
+//! Maps the element type of a property to its PROP_TYPE
+template <typename T> struct AbcPropertyTraits;
+template <> struct AbcPropertyTraits<float> { static const PROP_TYPE type = FLOAT; };
+template <> struct AbcPropertyTraits<Alembic::Abc::V3f> { static const PROP_TYPE type = VECTOR; };
+template <> struct AbcPropertyTraits<int> { static const PROP_TYPE type = INT; };
+template <> struct AbcPropertyTraits<Alembic::Abc::V2f> { static const PROP_TYPE type = VECTOR2; };
+template <> struct AbcPropertyTraits<Alembic::Abc::Quatf> { static const PROP_TYPE type = QUAT; };
+template <> struct AbcPropertyTraits<std::string> { static const PROP_TYPE type = STRING; };
+
+//! Resolved, typed reference to an arbitrary geometry property.
+//! Obtain it once (AbcReader::getPropertyHandle) and use it every sample instead of the property name.
+template <typename T>
+class AbcPropertyHandle
+{
+public:
+	AbcPropertyHandle() : m_slot(-1) {}
+	explicit AbcPropertyHandle(int slot) : m_slot(slot) {}
+
+	bool valid() const { return m_slot >= 0; }
+	int slot() const { return m_slot; }
+
+private:
+	int m_slot;
+};
+
+//! Parse a command line property "name:type" (type is one of float, vector, int, vector2, quat) into a POINT scoped
+//! entry of properties. Returns false for anything else.
+inline bool parsePropertySpec(const std::string& spec, std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& properties)
+{
+	size_t colon = spec.rfind(':');
+	if(colon == std::string::npos)
+	{
+		return false;
+	}
+
+	std::string name = spec.substr(0, colon);
+	std::string type = spec.substr(colon + 1);
+	if(type == "float") properties.emplace_back(name, FLOAT, POINT);
+	else if(type == "vector") properties.emplace_back(name, VECTOR, POINT);
+	else if(type == "int") properties.emplace_back(name, INT, POINT);
+	else if(type == "vector2") properties.emplace_back(name, VECTOR2, POINT);
+	else if(type == "quat") properties.emplace_back(name, QUAT, POINT);
+	else return false;
+	return true;
+}
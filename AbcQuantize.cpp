@@ -0,0 +1,213 @@
+#include "AbcQuantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "AbcBounds.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EASYABC_SSE2 1
+#endif
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+//scalars per SSE step, a multiple of every supported extent
+static const size_t QUANTIZE_STEP = 12;
+
+//! Per lane values for 12 consecutive scalars, lane k belongs to component k % extent
+static void lanePattern(const float* perComponent, int extent, float* lanes)
+{
+	for(size_t k = 0; k < QUANTIZE_STEP; ++k)
+	{
+		lanes[k] = perComponent[k % extent];
+	}
+}
+
+void encodeHalf(const float* in, size_t count, Alembic::Util::float16_t* out)
+{
+	size_t i = 0;
+
+#ifdef __F16C__
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm_storel_epi64((__m128i*)(out + i), _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		out[i] = Alembic::Util::float16_t(in[i]);
+	}
+}
+
+void decodeHalf(const Alembic::Util::float16_t* in, size_t count, float* out)
+{
+	size_t i = 0;
+
+#ifdef __F16C__
+	for(; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(out + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(in + i))));
+	}
+#endif
+
+	//half converts through a lookup table
+	for(; i < count; ++i)
+	{
+		out[i] = in[i];
+	}
+}
+
+void componentRange(const float* in, size_t count, int extent, float* min, float* max)
+{
+	if(count < (size_t)extent)
+	{
+		std::fill(min, min + extent, 0.0f);
+		std::fill(max, max + extent, 0.0f);
+		return;
+	}
+
+	if(extent == 3)
+	{
+		//same SSE and threading as the mesh bounds
+		Alembic::Abc::Box3d bounds = computeBounds((const Alembic::Abc::V3f*)in, count / 3);
+		for(int c = 0; c < 3; ++c)
+		{
+			min[c] = (float)bounds.min[c];
+			max[c] = (float)bounds.max[c];
+		}
+		return;
+	}
+
+	std::copy(in, in + extent, min);
+	std::copy(in, in + extent, max);
+	for(size_t i = extent; i < count; ++i)
+	{
+		const int c = i % extent;
+		min[c] = std::min(min[c], in[i]);
+		max[c] = std::max(max[c], in[i]);
+	}
+}
+
+void quantize16(const float* in, size_t count, int extent, const float* min, const float* max, uint16_t* out)
+{
+	float scale[4];
+	for(int c = 0; c < extent; ++c)
+	{
+		scale[c] = max[c] > min[c] ? 65535.0f / (max[c] - min[c]) : 0.0f;
+	}
+	size_t i = 0;
+
+#ifdef EASYABC_SSE2
+	float offsetLanes[QUANTIZE_STEP], scaleLanes[QUANTIZE_STEP];
+	lanePattern(min, extent, offsetLanes);
+	lanePattern(scale, extent, scaleLanes);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 limit = _mm_set1_ps(65535.0f);
+	//packs saturates signed, so pack around 0 and flip the sign bit back
+	const __m128i bias = _mm_set1_epi32(32768);
+	const __m128i sign = _mm_set1_epi16((short)0x8000);
+	for(; i + QUANTIZE_STEP <= count; i += QUANTIZE_STEP)
+	{
+		__m128i q[3];
+		for(int r = 0; r < 3; ++r)
+		{
+			__m128 v = _mm_sub_ps(_mm_loadu_ps(in + i + r * 4), _mm_loadu_ps(offsetLanes + r * 4));
+			v = _mm_mul_ps(v, _mm_loadu_ps(scaleLanes + r * 4));
+			v = _mm_min_ps(_mm_max_ps(v, zero), limit);
+			q[r] = _mm_sub_epi32(_mm_cvtps_epi32(v), bias);
+		}
+		_mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(_mm_packs_epi32(q[0], q[1]), sign));
+		_mm_storel_epi64((__m128i*)(out + i + 8), _mm_xor_si128(_mm_packs_epi32(q[2], q[2]), sign));
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		const int c = i % extent;
+		const float v = std::min(std::max((in[i] - min[c]) * scale[c], 0.0f), 65535.0f);
+		out[i] = (uint16_t)std::lrint(v);
+	}
+}
+
+void dequantize16(const uint16_t* in, size_t count, int extent, const float* min, const float* max, float* out)
+{
+	float step[4];
+	for(int c = 0; c < extent; ++c)
+	{
+		step[c] = (max[c] - min[c]) / 65535.0f;
+	}
+	size_t i = 0;
+
+#ifdef EASYABC_SSE2
+	float offsetLanes[QUANTIZE_STEP], stepLanes[QUANTIZE_STEP];
+	lanePattern(min, extent, offsetLanes);
+	lanePattern(step, extent, stepLanes);
+	const __m128i zero = _mm_setzero_si128();
+	for(; i + QUANTIZE_STEP <= count; i += QUANTIZE_STEP)
+	{
+		for(int r = 0; r < 3; ++r)
+		{
+			__m128i q = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(in + i + r * 4)), zero);
+			__m128 v = _mm_mul_ps(_mm_cvtepi32_ps(q), _mm_loadu_ps(stepLanes + r * 4));
+			_mm_storeu_ps(out + i + r * 4, _mm_add_ps(v, _mm_loadu_ps(offsetLanes + r * 4)));
+		}
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		const int c = i % extent;
+		out[i] = min[c] + in[i] * step[c];
+	}
+}
+
+void encodeUnorm8(const float* in, size_t count, uint8_t* out)
+{
+	size_t i = 0;
+
+#ifdef EASYABC_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 scale = _mm_set1_ps(255.0f);
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), zero), scale);
+		__m128i q = _mm_cvtps_epi32(v);
+		q = _mm_packs_epi32(q, q);
+		q = _mm_packus_epi16(q, q);
+		int packed = _mm_cvtsi128_si32(q);
+		std::memcpy(out + i, &packed, 4);
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		out[i] = (uint8_t)std::lrint(std::min(std::max(in[i] * 255.0f, 0.0f), 255.0f));
+	}
+}
+
+void decodeUnorm8(const uint8_t* in, size_t count, float* out)
+{
+	size_t i = 0;
+
+#ifdef EASYABC_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+	for(; i + 4 <= count; i += 4)
+	{
+		int packed;
+		std::memcpy(&packed, in + i, 4);
+		__m128i q = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(q), scale));
+	}
+#endif
+
+	for(; i < count; ++i)
+	{
+		out[i] = in[i] * (1.0f / 255.0f);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Alembic/Abc/All.h>
+
+//! Metadata of properties AbcWriter stored encoded: the encoding ("half", "quantized16" or "unorm8"),
+//! the declared type ("float" or "vector", the stored scalars do not tell them apart)
+//! and for quantized16 the name of the Box3f user property holding each sample's per-component range
+static const char* const ABC_ENCODING_KEY = "easyAbc_encoding";
+static const char* const ABC_TYPE_KEY = "easyAbc_type";
+static const char* const ABC_RANGE_KEY = "easyAbc_range";
+
+//Encoders and decoders for reduced precision properties (see PROP_ENCODING).
+//All of them work on count scalars. Vectors are passed as extent interleaved components,
+//extent has to divide 12 (1, 2, 3 or 4). SSE processes 12 scalars per step.
+
+//! float -> half, rounding to nearest (F16C when compiled with -mf16c)
+void encodeHalf(const float* in, size_t count, Alembic::Util::float16_t* out);
+void decodeHalf(const Alembic::Util::float16_t* in, size_t count, float* out);
+
+//! Smallest and largest value of each of the extent components, 0 for none
+void componentRange(const float* in, size_t count, int extent, float* min, float* max);
+
+//! Fixed point against [min, max] of every component, 65535 steps
+void quantize16(const float* in, size_t count, int extent, const float* min, const float* max, uint16_t* out);
+void dequantize16(const uint16_t* in, size_t count, int extent, const float* min, const float* max, float* out);
+
+//! [0, 1] in 255 steps, values outside are clamped
+void encodeUnorm8(const float* in, size_t count, uint8_t* out);
+void decodeUnorm8(const uint8_t* in, size_t count, float* out);
@@ -1,228 +1,1193 @@
 #include "AbcReader.h"
 
+#include <algorithm>
+
+#include <boost/thread/mutex.hpp>
+
 #include <Alembic/AbcGeom/All.h>
 #include <Alembic/AbcCoreHDF5/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
 #include <Alembic/AbcCoreFactory/All.h>
 
+#include "AbcThreadPool.h"
+#include "AbcSoA.h"
+#include "AbcNormals.h"
+#include "AbcQuantize.h"
+#include "AbcInterpolate.h"
+#include "AbcBounds.h"
+
+//! Reads one arbGeomParam, resolved at open time, into its slot of a sample
+class AbcPropertyReader
+{
+public:
+	virtual ~AbcPropertyReader() {}
+	virtual void read(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample, bool expandIndexed) const = 0;
+};
+
+template <typename GEOMPARAM, typename T>
+class AbcGeomParamReader : public AbcPropertyReader
+{
+public:
+	AbcGeomParamReader(const Alembic::AbcGeom::ICompoundProperty& parent, const std::string& name, int slot)
+		: m_param(parent, name), m_slot(slot), m_indexed(m_param.isIndexed()) {}
+
+	void read(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample, bool expandIndexed) const
+	{
+		if(m_indexed && !expandIndexed)
+		{
+			typename GEOMPARAM::Sample indexed = m_param.getIndexedValue(sampleSelector);
+			sample.getProperties<T>()[m_slot] = AbcArrayView<T>(indexed.getVals());
+			sample.propertyIndices[AbcPropertyTraits<T>::type][m_slot] = AbcArrayView<uint32_t>(indexed.getIndices());
+			return;
+		}
+		sample.getProperties<T>()[m_slot] = AbcArrayView<T>(m_param.getExpandedValue(sampleSelector).getVals());
+	}
+
+private:
+	GEOMPARAM m_param;
+	int m_slot;
+	bool m_indexed;
+};
+
+//! Decodes a FLOAT or VECTOR property AbcWriter stored with a PROP_ENCODING, SCALAR is its stored component type
+template <typename GEOMPARAM, typename SCALAR, typename T>
+class AbcEncodedParamReader : public AbcPropertyReader
+{
+public:
+	AbcEncodedParamReader(const Alembic::AbcGeom::ICompoundProperty& parent, const std::string& name, int slot,
+		const Alembic::Abc::IBox3fProperty& range = Alembic::Abc::IBox3fProperty())
+		: m_param(parent, name), m_slot(slot), m_range(range) {}
+
+	void read(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample, bool) const
+	{
+		typename GEOMPARAM::prop_type::sample_ptr_type vals = m_param.getExpandedValue(sampleSelector).getVals();
+		if(!vals)
+		{
+			return;
+		}
+
+		const size_t extent = sizeof(T) / sizeof(float);
+		const size_t count = vals->size() * sizeof(*vals->get()) / sizeof(SCALAR);
+		std::vector<T> values(count / extent);
+		decode((const SCALAR*)vals->get(), values.size() * extent, (float*)values.data(), sampleSelector);
+		sample.getProperties<T>()[m_slot] = AbcArrayView<T>::adopt(std::move(values));
+	}
+
+private:
+	void decode(const Alembic::Util::float16_t* in, size_t count, float* out, const Alembic::Abc::ISampleSelector&) const
+	{
+		decodeHalf(in, count, out);
+	}
+
+	void decode(const uint16_t* in, size_t count, float* out, const Alembic::Abc::ISampleSelector& sampleSelector) const
+	{
+		Alembic::Abc::Box3f range;
+		m_range.get(range, sampleSelector);
+		dequantize16(in, count, sizeof(T) / sizeof(float), &range.min.x, &range.max.x, out);
+	}
+
+	void decode(const uint8_t* in, size_t count, float* out, const Alembic::Abc::ISampleSelector&) const
+	{
+		decodeUnorm8(in, count, out);
+	}
+
+	GEOMPARAM m_param;
+	int m_slot;
+	Alembic::Abc::IBox3fProperty m_range;
+};
+
+template <typename T>
+static std::shared_ptr<AbcPropertyReader>
+createEncodedPropertyReader(const Alembic::AbcGeom::ICompoundProperty& arbGeomPs, const Alembic::AbcGeom::ICompoundProperty& userProperties,
+	const Alembic::Abc::PropertyHeader& header, int slot)
+{
+	using namespace Alembic::AbcGeom;
+
+	const std::string& name = header.getName();
+	const std::string encoding = header.getMetaData().get(ABC_ENCODING_KEY);
+	if(encoding == "half" && IHalfGeomParam::matches(header))
+	{
+		return std::make_shared<AbcEncodedParamReader<IHalfGeomParam, Alembic::Util::float16_t, T>>(arbGeomPs, name, slot);
+	}
+	if(encoding == "quantized16" && IUInt16GeomParam::matches(header))
+	{
+		const std::string rangeName = header.getMetaData().get(ABC_RANGE_KEY);
+		if(!userProperties.valid() || !userProperties.getPropertyHeader(rangeName))
+		{
+			std::cout << "ERROR: Range of quantized property " << name << " is missing, it cannot be decoded." << std::endl;
+			return nullptr;
+		}
+		return std::make_shared<AbcEncodedParamReader<IUInt16GeomParam, uint16_t, T>>(arbGeomPs, name, slot,
+			Alembic::Abc::IBox3fProperty(userProperties, rangeName));
+	}
+	if(encoding == "unorm8" && IC3cGeomParam::matches(header))
+	{
+		return std::make_shared<AbcEncodedParamReader<IC3cGeomParam, uint8_t, T>>(arbGeomPs, name, slot);
+	}
+	if(encoding == "unorm8" && IUcharGeomParam::matches(header))
+	{
+		return std::make_shared<AbcEncodedParamReader<IUcharGeomParam, uint8_t, T>>(arbGeomPs, name, slot);
+	}
+
+	std::cout << "ERROR: Unsupported encoding " << encoding << " of property " << name << ", it cannot be decoded." << std::endl;
+	return nullptr;
+}
+
+//! Picks the alembic param class for a declared property, nullptr if the file does not hold a matching one
+static std::shared_ptr<AbcPropertyReader>
+createPropertyReader(const Alembic::AbcGeom::ICompoundProperty& arbGeomPs, const Alembic::AbcGeom::ICompoundProperty& userProperties,
+	const std::string& name, PROP_TYPE type, int slot)
+{
+	using namespace Alembic::AbcGeom;
+
+	const Alembic::Abc::PropertyHeader* header = arbGeomPs.getPropertyHeader(name);
+	if(!header)
+	{
+		return nullptr;
+	}
+
+	//reduced precision properties written by AbcWriter decode to plain floats
+	if(!header->getMetaData().get(ABC_ENCODING_KEY).empty())
+	{
+		if(type == FLOAT)
+			return createEncodedPropertyReader<float>(arbGeomPs, userProperties, *header, slot);
+		if(type == VECTOR)
+			return createEncodedPropertyReader<Alembic::Abc::V3f>(arbGeomPs, userProperties, *header, slot);
+	}
+
+	switch(type)
+	{
+	case FLOAT:
+		if(IFloatGeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IFloatGeomParam, float>>(arbGeomPs, name, slot);
+		break;
+	case VECTOR:
+		//colours, normals and points share the V3f layout
+		if(IC3fGeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IC3fGeomParam, Alembic::Abc::V3f>>(arbGeomPs, name, slot);
+		if(IN3fGeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IN3fGeomParam, Alembic::Abc::V3f>>(arbGeomPs, name, slot);
+		if(IP3fGeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IP3fGeomParam, Alembic::Abc::V3f>>(arbGeomPs, name, slot);
+		if(IV3fGeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IV3fGeomParam, Alembic::Abc::V3f>>(arbGeomPs, name, slot);
+		break;
+	case INT:
+		if(IInt32GeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IInt32GeomParam, int>>(arbGeomPs, name, slot);
+		break;
+	case VECTOR2:
+		if(IV2fGeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IV2fGeomParam, Alembic::Abc::V2f>>(arbGeomPs, name, slot);
+		break;
+	case QUAT:
+		if(IQuatfGeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IQuatfGeomParam, Alembic::Abc::Quatf>>(arbGeomPs, name, slot);
+		break;
+	case STRING:
+		if(IStringGeomParam::matches(*header))
+			return std::make_shared<AbcGeomParamReader<IStringGeomParam, std::string>>(arbGeomPs, name, slot);
+		break;
+	default:
+		break;
+	}
+
+	return nullptr;
+}
+
+template <typename T>
+static void resetProperties(AbcSample& sample, size_t count)
+{
+	sample.getProperties<T>().assign(count, AbcArrayView<T>());
+	sample.propertyIndices[AbcPropertyTraits<T>::type].assign(count, AbcArrayView<uint32_t>());
+}
+
+//! Every declared property of a sample, empty until read
+static void resetAllProperties(AbcSample& sample, const std::vector<size_t>& numProperties)
+{
+	sample.propertyIndices.resize(NUM_PROP_TYPES);
+	resetProperties<float>(sample, numProperties[FLOAT]);
+	resetProperties<Alembic::Abc::V3f>(sample, numProperties[VECTOR]);
+	resetProperties<int>(sample, numProperties[INT]);
+	resetProperties<Alembic::Abc::V2f>(sample, numProperties[VECTOR2]);
+	resetProperties<Alembic::Abc::Quatf>(sample, numProperties[QUAT]);
+	resetProperties<std::string>(sample, numProperties[STRING]);
+}
+
+//! Bytes and buffers decoded for a list of properties
+template <typename T>
+static void countProperties(const AbcSample& sample, uint64_t& bytes, uint64_t& buffers)
+{
+	for(auto& p : sample.getProperties<T>())
+	{
+		bytes += p.size() * sizeof(T);
+		buffers += p.empty() ? 0 : 1;
+	}
+}
+
+//! Bytes and buffers decoded for one property, with its indices
+template <typename T>
+static void countProperty(const AbcSample& sample, int slot, uint64_t& bytes, uint64_t& buffers)
+{
+	const AbcArrayView<T>& values = sample.getProperties<T>()[slot];
+	const AbcArrayView<uint32_t>& indices = sample.propertyIndices[AbcPropertyTraits<T>::type][slot];
+	bytes += values.size() * sizeof(T) + indices.size() * sizeof(uint32_t);
+	buffers += (values.empty() ? 0 : 1) + (indices.empty() ? 0 : 1);
+}
+
+//! Copies view into values, counting it as an allocation if values had to grow
+template <typename T>
+static void copyView(std::vector<T>& values, const AbcArrayView<T>& view, AbcStats& stats)
+{
+	const size_t capacity = values.capacity();
+	values.assign(view.begin(), view.end());
+	if(values.capacity() != capacity)
+	{
+		stats.addAllocations(1);
+	}
+}
+
 struct AbcReaderImp
 {
 	std::shared_ptr<Alembic::Abc::IArchive> archive;
 	std::shared_ptr<Alembic::AbcGeom::IPolyMesh> mesh;
 	std::shared_ptr<Alembic::AbcGeom::IXform> transform;
 
-	int numSamples;
-	int currentSample;
-};
+	int numSamples;
+	int currentSample;
+
+	//resolved once per bind, read every sample without any lookups
+	Alembic::AbcGeom::IN3fGeomParam normals;
+	bool hasNormals;
+	Alembic::Abc::IV3fArrayProperty velocities;
+	Alembic::AbcCoreAbstract::TimeSamplingPtr timeSampling;
+	AbcNormalGenerator normalGenerator;
+	AbcTriangulator triangulator;
+	std::vector<std::shared_ptr<AbcPropertyReader>> properties;
+	//the same readers by PROP_TYPE and slot, null for properties missing in the file
+	std::vector<std::vector<std::shared_ptr<AbcPropertyReader>>> slotReaders;
+
+	//topology of the last decoded sample, reused while the array digests do not change
+	Alembic::AbcGeom::MeshTopologyVariance topologyVariance;
+	boost::mutex topologyMutex;
+	bool topologyCached;
+	Alembic::Abc::ArraySampleKey faceIndicesKey;
+	Alembic::Abc::ArraySampleKey faceCountsKey;
+	AbcArrayView<int> faceIndices;
+	AbcArrayView<int> faceCounts;
+};
+
+AbcReader::AbcReader() : m_readMode(READ_VIEW), m_normalsMode(NORMALS_FROM_FILE), m_generatedNormalsScope(POINT),
+	m_expandIndexed(true), m_lazy(false), m_pendingParts(0), m_copiedParts(0), m_topologyChanged(true), m_numStreams(1), m_archivePool(nullptr)
+{
+	m_data = std::make_shared<AbcReaderImp>();
+	m_stats = std::make_shared<AbcStats>();
+	m_data->hasNormals = false;
+	m_numProperties.assign(NUM_PROP_TYPES, 0);
+}
+
+
+AbcReader::~AbcReader()
+{
+	//the worker decodes through this reader, stop it before anything else goes away
+	m_prefetcher.reset();
+}
+
+
+int AbcReader::findPropertySlot(const std::string& name, PROP_TYPE type) const
+{
+	auto it = m_propertySlots.find(name);
+	if(it == m_propertySlots.end() || it->second.first != type)
+	{
+		std::cout << "ERROR: Property " << name << " was not declared with this type when opening the archive." << std::endl;
+		return -1;
+	}
+	return it->second.second;
+}
+
+std::vector<std::string> AbcReader::getPropertyNames(PROP_TYPE type) const
+{
+	std::vector<std::string> names(type < NUM_PROP_TYPES ? m_numProperties[type] : 0);
+	for(auto& p : m_propertySlots)
+	{
+		if(p.second.first == type)
+		{
+			names[p.second.second] = p.first;
+		}
+	}
+	return names;
+}
+
+std::vector<float>& AbcReader::getFloatProperty(const std::string& name)
+{
+	int slot = findPropertySlot(name, FLOAT);
+	if(!requireCopiedProperty(FLOAT, slot) || slot >= (int)m_arbGeoFloatProperties.size())
+	{
+		m_missingFloatProperty.clear();
+		return m_missingFloatProperty;
+	}
+	return m_arbGeoFloatProperties[slot];
+}
+
+std::vector<Alembic::Abc::V3f>& AbcReader::getVectorProperty(const std::string& name)
+{
+	int slot = findPropertySlot(name, VECTOR);
+	if(!requireCopiedProperty(VECTOR, slot) || slot >= (int)m_arbGeoVectorProperties.size())
+	{
+		m_missingVectorProperty.clear();
+		return m_missingVectorProperty;
+	}
+	return m_arbGeoVectorProperties[slot];
+}
+
+const AbcArrayView<float>& AbcReader::getFloatPropertyView(const std::string& name)
+{
+	return getProperty(AbcPropertyHandle<float>(findPropertySlot(name, FLOAT)));
+}
+
+const AbcArrayView<Alembic::Abc::V3f>& AbcReader::getVectorPropertyView(const std::string& name)
+{
+	return getProperty(AbcPropertyHandle<Alembic::Abc::V3f>(findPropertySlot(name, VECTOR)));
+}
+
+std::shared_ptr<const AbcTriangulation> AbcReader::getTriangulation()
+{
+	require(LAZY_POSITIONS | LAZY_TOPOLOGY);
+	return m_data->triangulator.triangulate(m_sample.faceIndices, m_sample.faceCounts, m_sample.positions.size());
+}
+
+void AbcReader::setNormalsMode(NORMALS_MODE mode, PROP_SCOPE scope)
+{
+	if(mode == m_normalsMode && scope == m_generatedNormalsScope)
+	{
+		return;
+	}
+
+	//prefetched and cached samples carry the old normals
+	discardDecodedSamples();
+
+	m_normalsMode = mode;
+	m_generatedNormalsScope = scope;
+	if(m_sample.index >= 0)
+	{
+		readCurrentSampleIntoMemory();
+	}
+}
+
+void AbcReader::setExpandIndexedProperties(bool expand)
+{
+	if(expand == m_expandIndexed)
+	{
+		return;
+	}
+
+	//prefetched and cached samples hold the other layout
+	discardDecodedSamples();
+
+	m_expandIndexed = expand;
+	if(m_sample.index >= 0)
+	{
+		readCurrentSampleIntoMemory();
+	}
+}
+
+void AbcReader::setLazyDecode(bool lazy)
+{
+	if(lazy == m_lazy)
+	{
+		return;
+	}
+
+	//a half decoded sample is completed, stepping from here on decodes everything again
+	if(!lazy)
+	{
+		require(LAZY_ALL);
+	}
+	else if(m_prefetcher)
+	{
+		m_prefetcher->cancel();
+	}
+	m_lazy = lazy;
+}
+
+void AbcReader::setReadMode(READ_MODE mode)
+{
+	//the transposes and copies below cover the whole sample
+	if(mode != m_readMode)
+	{
+		require(LAZY_ALL);
+	}
+
+	//samples decoded so far were (or were not) transposed for the old mode
+	const bool soaChanged = (mode == READ_SOA) != (m_readMode == READ_SOA);
+	if(soaChanged)
+	{
+		discardDecodedSamples();
+	}
+
+	m_readMode = mode;
+	if(soaChanged && m_sample.index >= 0)
+	{
+		transposeSample(m_sample);
+	}
+
+	//switching to copy mode while a sample is loaded fills the vectors straight away
+	if(m_readMode == READ_COPY && m_sample.index >= 0)
+	{
+		copySampleIntoMemory();
+	}
+}
+
+
+
+bool
+AbcReader::openArchive(const std::string& file, const std::string& xFormName, const std::string& meshName,
+	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+{
+	if(m_archivePool)
+	{
+		std::shared_ptr<Alembic::Abc::IArchive> archive = m_archivePool->acquire(file);
+		return archive && openArchive(archive, xFormName, meshName, arbGeoProperties);
+	}
+
+	Alembic::AbcCoreFactory::IFactory factory;
+	factory.setPolicy(Alembic::Abc::ErrorHandler::kQuietNoopPolicy);
+	Alembic::AbcCoreFactory::IFactory::CoreType coreType;
+	factory.setOgawaNumStreams(m_numStreams);
+
+	//Open archive
+	std::shared_ptr<Alembic::Abc::IArchive> archive =
+		std::make_shared<Alembic::Abc::IArchive>(factory.getArchive(file, coreType));
+	if(!archive->valid())
+	{
+		std::cout << "ERROR: Alembic Archive [" << file << "] could not be opened!" << std::endl;
+		return false;
+	}
+
+	return openArchive(archive, xFormName, meshName, arbGeoProperties);
+}
+
+bool
+AbcReader::openArchive(const std::shared_ptr<Alembic::Abc::IArchive>& archive, const std::string& xFormName,
+	const std::string& meshName, const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+{
+	if(!bindMesh(archive, xFormName, meshName, arbGeoProperties))
+	{
+		return false;
+	}
+
+	//make sure to read the first sample into memory
+	sampleSpecific(0);
+
+	return true;
+}
+
+bool
+AbcReader::openArchive(const AbcArchiveIndex& index, const std::string& meshPath,
+	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+{
+	const AbcObjectInfo* object = index.find(meshPath);
+	if(!object || object->type != OBJECT_POLYMESH)
+	{
+		std::cout << "ERROR: There is no mesh at " << meshPath << " in the indexed archive." << std::endl;
+		return false;
+	}
+
+	if(!bindObject(index.getArchive(), object->object, arbGeoProperties))
+	{
+		return false;
+	}
+
+	//make sure to read the first sample into memory
+	sampleSpecific(0);
+
+	return true;
+}
+
+bool
+AbcReader::bindMesh(const std::shared_ptr<Alembic::Abc::IArchive>& archive, const std::string& xFormName,
+	const std::string& meshName, const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+{
+	if(!archive || !archive->valid())
+	{
+		std::cout << "ERROR: Invalid Alembic Archive, cannot read mesh " << meshName << std::endl;
+		return false;
+	}
+
+	//get the top node, the transform below it and the mesh below that
+	Alembic::Abc::IObject topObject(*archive, Alembic::Abc::kTop);
+	Alembic::Abc::IObject transform(topObject, xFormName);
+	return bindObject(archive, Alembic::Abc::IObject(transform, meshName), arbGeoProperties);
+}
+
+bool
+AbcReader::bindObject(const std::shared_ptr<Alembic::Abc::IArchive>& archive, const Alembic::Abc::IObject& meshObject,
+	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+{
+	//nothing may be decoding while we rebind
+	if(m_prefetcher)
+	{
+		m_prefetcher->cancel(true);
+	}
+
+	if(!archive || !archive->valid())
+	{
+		std::cout << "ERROR: Invalid Alembic Archive, cannot read mesh " << meshObject.getName() << std::endl;
+		return false;
+	}
+	m_data->archive = archive;
+	const std::string& meshName = meshObject.getName();
+
+	//get the transform
+	m_data->transform =
+		std::make_shared<Alembic::AbcGeom::IXform>(meshObject.getParent(), Alembic::AbcGeom::kWrapExisting);
+
+	//get the mesh
+	m_data->mesh = std::make_shared<Alembic::AbcGeom::IPolyMesh>(meshObject, Alembic::AbcGeom::kWrapExisting);
+
+	//get mesh properties
+	Alembic::AbcGeom::IPolyMeshSchema& schema = m_data->mesh->getSchema();
+
+	//build internal dicationary and resolve every property once
+	Alembic::AbcGeom::ICompoundProperty arbGeomPs = schema.getArbGeomParams();
+	Alembic::AbcGeom::ICompoundProperty userProperties = schema.getUserProperties();
+	m_propertySlots.clear();
+	m_numProperties.assign(NUM_PROP_TYPES, 0);
+	m_data->properties.clear();
+	m_data->slotReaders.assign(NUM_PROP_TYPES, std::vector<std::shared_ptr<AbcPropertyReader>>());
+	for(auto& p : arbGeoProperties)
+	{
+		const std::string& name = std::get<0>(p);
+		PROP_TYPE type = std::get<1>(p);
+		if(type >= NUM_PROP_TYPES)
+		{
+			std::cout << "ERROR: Unrecognised Property Type. This will not be read! (" << name << ")" << std::endl;
+			continue;
+		}
+
+		int slot = (int)m_numProperties[type]++;
+		m_propertySlots.emplace(std::make_pair(name, std::make_pair(type, slot)));
+
+		std::shared_ptr<AbcPropertyReader> reader = createPropertyReader(arbGeomPs, userProperties, name, type, slot);
+		m_data->slotReaders[type].push_back(reader);
+		if(reader)
+		{
+			m_data->properties.push_back(reader);
+		}
+		else
+		{
+			std::cout << "WARNING: Property " << name << " of the requested type not found on " << meshName << ", it will be empty." << std::endl;
+		}
+	}
+
+	m_data->normals = schema.getNormalsParam();
+	m_data->hasNormals = m_data->normals.valid();
+	m_data->velocities = schema.getVelocitiesProperty();
+	m_data->timeSampling = schema.getTimeSampling();
+
+	//print some debug stuff
+	std::cout << "Num Poly Mesh Schema Samples Read From file: " << schema.getNumSamples() << std::endl;
+	m_data->numSamples = schema.getNumSamples();
+	m_data->currentSample = 0;
+	m_stats->setLabel(archive->getName() + " " + meshName);
+
+	//forget the topology of whatever was bound before
+	m_data->topologyVariance = schema.getTopologyVariance();
+	{
+		boost::unique_lock<boost::mutex> lock(m_data->topologyMutex);
+		m_data->topologyCached = false;
+		m_data->faceIndices = AbcArrayView<int>();
+		m_data->faceCounts = AbcArrayView<int>();
+	}
+	m_sample = AbcSample();
+	m_pendingParts = 0;
+	forgetCopies();
+	m_previousFaceIndices = AbcArrayView<int>();
+	m_previousFaceCounts = AbcArrayView<int>();
+	m_timeFloor = AbcSample();
+	m_timeCeil = AbcSample();
+	if(m_cache)
+	{
+		m_cache->clear();
+	}
+
+	return true;
+}
+
+void
+AbcReader::discardDecodedSamples()
+{
+	cancelPrefetch(true);
+	if(m_cache)
+	{
+		m_cache->clear();
+	}
+	m_timeFloor = AbcSample();
+	m_timeCeil = AbcSample();
+}
+
+//! True if sample does not hand out the very same topology buffers as before
+static bool topologyDiffers(const AbcSample& sample, const AbcArrayView<int>& previousFaceIndices, const AbcArrayView<int>& previousFaceCounts)
+{
+	return sample.faceIndices.data() != previousFaceIndices.data()
+		|| sample.faceCounts.data() != previousFaceCounts.data()
+		|| sample.faceIndices.size() != previousFaceIndices.size()
+		|| sample.faceCounts.size() != previousFaceCounts.size();
+}
+
+void
+AbcReader::lastTopology(AbcArrayView<int>& faceIndices, AbcArrayView<int>& faceCounts) const
+{
+	//a lazy sample that never decoded its topology leaves the one before it as the last handed out
+	faceIndices = (m_pendingParts & LAZY_TOPOLOGY) ? m_previousFaceIndices : m_sample.faceIndices;
+	faceCounts = (m_pendingParts & LAZY_TOPOLOGY) ? m_previousFaceCounts : m_sample.faceCounts;
+}
+
+bool
+AbcReader::generatesNormals() const
+{
+	return m_normalsMode == NORMALS_GENERATE_ALWAYS
+		|| (m_normalsMode == NORMALS_GENERATE_MISSING && !m_data->hasNormals);
+}
+
+void
+AbcReader::readCurrentSampleIntoMemory(int direction)
+{
+	AbcStatsTimer timer(*m_stats, READ_SAMPLE);
+
+	//holding on to the old topology keeps its buffers from being recycled while we compare
+	AbcArrayView<int> previousFaceIndices;
+	AbcArrayView<int> previousFaceCounts;
+	lastTopology(previousFaceIndices, previousFaceCounts);
+	m_pendingParts = 0;
+	forgetCopies();
+	m_previousFaceIndices = AbcArrayView<int>();
+	m_previousFaceCounts = AbcArrayView<int>();
+
+	if(m_lazy)
+	{
+		if(m_prefetcher)
+		{
+			m_prefetcher->cancel();
+		}
+
+		//only a cached sample is already decoded
+		if(!m_cache || !m_cache->find(m_data->currentSample, m_sample))
+		{
+			m_previousFaceIndices = previousFaceIndices;
+			m_previousFaceCounts = previousFaceCounts;
+			startLazySample();
+			return;
+		}
+	}
+	else if(m_prefetcher && direction != 0)
+	{
+		//stepping: swap in the prefetched sample, or decode it now and restart prefetching from here
+		if(!m_prefetcher->take(m_data->currentSample, direction, m_sample))
+		{
+			loadSample(m_data->currentSample, m_sample);
+			m_prefetcher->start(m_data->currentSample, direction, m_data->numSamples);
+		}
+	}
+	else
+	{
+		//jumping: whatever was prefetched is useless now
+		if(m_prefetcher)
+		{
+			m_prefetcher->cancel();
+		}
+		loadSample(m_data->currentSample, m_sample);
+	}
+
+	//unchanged topology is handed out as the very same cached buffers
+	m_topologyChanged = topologyDiffers(m_sample, previousFaceIndices, previousFaceCounts);
+
+	if(m_readMode == READ_COPY)
+	{
+		copySampleIntoMemory(m_topologyChanged);
+	}
+}
+
+void
+AbcReader::startLazySample()
+{
+	m_sample = AbcSample();
+	m_sample.index = m_data->currentSample;
+	resetAllProperties(m_sample, m_numProperties);
+	if(m_readMode == READ_SOA)
+	{
+		m_sample.vectorPropertiesSoA.resize(m_numProperties[VECTOR]);
+	}
+	if(m_readMode == READ_COPY)
+	{
+		m_arbGeoFloatProperties.resize(m_numProperties[FLOAT]);
+		m_arbGeoVectorProperties.resize(m_numProperties[VECTOR]);
+	}
+
+	m_pendingParts = LAZY_ALL;
+	m_pendingProperties.resize(NUM_PROP_TYPES);
+	for(int type = 0; type < NUM_PROP_TYPES; ++type)
+	{
+		m_pendingProperties[type].assign(m_numProperties[type], true);
+	}
+}
+
+void
+AbcReader::decodePending(unsigned parts)
+{
+	//generated normals are computed from positions and topology
+	if((parts & LAZY_NORMALS) && generatesNormals())
+	{
+		parts |= LAZY_POSITIONS | LAZY_TOPOLOGY;
+	}
+	parts &= m_pendingParts;
+	if(parts & LAZY_PROPERTIES)
+	{
+		for(int type = 0; type < NUM_PROP_TYPES; ++type)
+		{
+			for(size_t slot = 0; slot < m_pendingProperties[type].size(); ++slot)
+			{
+				decodePendingProperty((PROP_TYPE)type, (int)slot);
+			}
+		}
+	}
+	m_pendingParts &= ~parts;
+	if(!(parts & (LAZY_POSITIONS | LAZY_TOPOLOGY | LAZY_NORMALS)))
+	{
+		return;
+	}
+
+	AbcStatsTimer decodeTimer(*m_stats, READ_DECODE);
+	Alembic::AbcGeom::ISampleSelector sampleSelector((Alembic::Abc::index_t)m_sample.index);
 
-AbcReader::AbcReader()
-{
-	m_data = std::make_shared<AbcReaderImp>();
-}
+	if(parts & LAZY_POSITIONS)
+	{
+		decodePositions(sampleSelector, m_sample);
+		if(m_readMode == READ_SOA)
+		{
+			AbcStatsTimer timer(*m_stats, READ_TRANSPOSE);
+			m_sample.positionsSoA = toSoA(m_sample.positions);
+			m_stats->addAllocations(m_sample.positions.empty() ? 0 : 1);
+		}
+		else if(m_readMode == READ_COPY)
+		{
+			AbcStatsTimer timer(*m_stats, READ_COPY_OUT);
+			copyView(m_positions, m_sample.positions, *m_stats);
+			copyView(m_velocities, m_sample.velocities, *m_stats);
+		}
+	}
 
+	if(parts & LAZY_TOPOLOGY)
+	{
+		decodeTopology(sampleSelector, m_sample);
+		m_topologyChanged = topologyDiffers(m_sample, m_previousFaceIndices, m_previousFaceCounts);
+		m_previousFaceIndices = AbcArrayView<int>();
+		m_previousFaceCounts = AbcArrayView<int>();
+		if(m_readMode == READ_COPY && m_topologyChanged)
+		{
+			AbcStatsTimer timer(*m_stats, READ_COPY_OUT);
+			copyView(m_faceIndices, m_sample.faceIndices, *m_stats);
+			copyView(m_faceCounts, m_sample.faceCounts, *m_stats);
+		}
+	}
 
-AbcReader::~AbcReader()
-{
+	if(parts & LAZY_NORMALS)
+	{
+		decodeNormals(sampleSelector, m_sample);
+		if(m_readMode == READ_SOA)
+		{
+			AbcStatsTimer timer(*m_stats, READ_TRANSPOSE);
+			m_sample.normalsSoA = toSoA(m_sample.normals);
+			m_stats->addAllocations(m_sample.normals.empty() ? 0 : 1);
+		}
+		else if(m_readMode == READ_COPY)
+		{
+			AbcStatsTimer timer(*m_stats, READ_COPY_OUT);
+			copyView(m_normals, m_sample.normals, *m_stats);
+		}
+	}
 }
 
-
-std::vector<float>& AbcReader::getFloatProperty(const std::string& name)
+void
+AbcReader::forgetCopies()
 {
-	return m_arbGeoFloatProperties[m_arbGeoPropertiesMap[name]];
+	m_copiedParts = 0;
+	m_copiedProperties.clear();
 }
 
-std::vector<Alembic::Abc::V3f>& AbcReader::getVectorProperty(const std::string& name)
+void
+AbcReader::requireCopy(unsigned parts)
 {
-	return m_arbGeoVectorProperties[m_arbGeoPropertiesMap[name]];
-}
-
+	require(parts);
+	parts &= ~m_copiedParts;
+	if(m_readMode == READ_COPY || !parts)
+	{
+		return;
+	}
 
+	//the views stay the sample's data, the copies are only made for callers of the vector accessors
+	AbcStatsTimer timer(*m_stats, READ_COPY_OUT);
+	if(parts & LAZY_POSITIONS)
+	{
+		copyView(m_positions, m_sample.positions, *m_stats);
+		copyView(m_velocities, m_sample.velocities, *m_stats);
+	}
+	if(parts & LAZY_TOPOLOGY)
+	{
+		copyView(m_faceIndices, m_sample.faceIndices, *m_stats);
+		copyView(m_faceCounts, m_sample.faceCounts, *m_stats);
+	}
+	if(parts & LAZY_NORMALS)
+	{
+		copyView(m_normals, m_sample.normals, *m_stats);
+	}
+	m_copiedParts |= parts;
+}
 
 bool
-AbcReader::openArchive(const std::string& file, const std::string& xFormName, const std::string& meshName,
-	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+AbcReader::requireCopiedProperty(PROP_TYPE type, int slot)
 {
-	Alembic::AbcCoreFactory::IFactory factory;
-	factory.setPolicy(Alembic::Abc::ErrorHandler::kQuietNoopPolicy);
-	Alembic::AbcCoreFactory::IFactory::CoreType coreType;
+	if(slot < 0)
+	{
+		return false;
+	}
+	requireProperty(type, slot);
+	if(m_readMode == READ_COPY)
+	{
+		return true;
+	}
 
-	//Open archive
-	m_data->archive =
-		std::make_shared<Alembic::Abc::IArchive>(factory.getArchive(file, coreType));
-	
-	//get the top node
-	Alembic::Abc::IObject topObject(*m_data->archive, Alembic::Abc::kTop);
+	m_copiedProperties.resize(NUM_PROP_TYPES);
+	std::vector<bool>& copied = m_copiedProperties[type];
+	copied.resize(m_numProperties[type], false);
+	if(slot >= (int)copied.size() || copied[slot])
+	{
+		return true;
+	}
+	copied[slot] = true;
 
-	//get the transform
-	m_data->transform =
-		std::make_shared<Alembic::AbcGeom::IXform>(Alembic::AbcGeom::IObject(topObject, xFormName), Alembic::AbcGeom::kWrapExisting);
+	AbcStatsTimer timer(*m_stats, READ_COPY_OUT);
+	if(type == FLOAT && slot < (int)m_sample.floatProperties.size())
+	{
+		m_arbGeoFloatProperties.resize(m_sample.floatProperties.size());
+		copyView(m_arbGeoFloatProperties[slot], m_sample.floatProperties[slot], *m_stats);
+	}
+	else if(type == VECTOR && slot < (int)m_sample.vectorProperties.size())
+	{
+		m_arbGeoVectorProperties.resize(m_sample.vectorProperties.size());
+		copyView(m_arbGeoVectorProperties[slot], m_sample.vectorProperties[slot], *m_stats);
+	}
+	return true;
+}
 
-	//get the mesh
-	m_data->mesh = std::make_shared<Alembic::AbcGeom::IPolyMesh>(Alembic::AbcGeom::IObject(*m_data->transform, meshName), Alembic::AbcGeom::kWrapExisting);
+void
+AbcReader::decodePendingProperty(PROP_TYPE type, int slot)
+{
+	if(type >= NUM_PROP_TYPES || slot < 0 || slot >= (int)m_pendingProperties[type].size() || !m_pendingProperties[type][slot])
+	{
+		return;
+	}
+	m_pendingProperties[type][slot] = false;
 
-	//get mesh properties
-	Alembic::AbcGeom::IPolyMeshSchema& schema = m_data->mesh->getSchema();
+	//missing in the file, stays empty
+	const std::shared_ptr<AbcPropertyReader>& reader = m_data->slotReaders[type][slot];
+	if(!reader)
+	{
+		return;
+	}
 
-	//build internal dicationary
-	m_numArbGeoFloatProps = 0;
-	m_numArbGeoVectorProps = 0;
-	for(auto& p : arbGeoProperties)
+	AbcStats& stats = *m_stats;
+	AbcStatsTimer decodeTimer(stats, READ_DECODE);
+	{
+		AbcStatsTimer timer(stats, READ_PROPERTIES);
+		reader->read(Alembic::AbcGeom::ISampleSelector((Alembic::Abc::index_t)m_sample.index), m_sample, m_expandIndexed);
+	}
+
+	if(stats.isEnabled())
 	{
-		if(std::get<1>(p) == PROP_TYPE::FLOAT)
+		uint64_t bytes = 0;
+		uint64_t buffers = 0;
+		switch(type)
 		{
-			m_arbGeoPropertiesMap.emplace(std::make_pair(std::get<0>(p), m_numArbGeoFloatProps));
-			++m_numArbGeoFloatProps;
+		case FLOAT: countProperty<float>(m_sample, slot, bytes, buffers); break;
+		case VECTOR: countProperty<Alembic::Abc::V3f>(m_sample, slot, bytes, buffers); break;
+		case INT: countProperty<int>(m_sample, slot, bytes, buffers); break;
+		case VECTOR2: countProperty<Alembic::Abc::V2f>(m_sample, slot, bytes, buffers); break;
+		case QUAT: countProperty<Alembic::Abc::Quatf>(m_sample, slot, bytes, buffers); break;
+		case STRING: countProperty<std::string>(m_sample, slot, bytes, buffers); break;
+		default: break;
 		}
-		else if(std::get<1>(p) == PROP_TYPE::VECTOR)
+		stats.addBytesRead(bytes);
+		stats.addAllocations(buffers);
+	}
+
+	if(type == VECTOR && m_readMode == READ_SOA)
+	{
+		AbcStatsTimer timer(stats, READ_TRANSPOSE);
+		m_sample.vectorPropertiesSoA[slot] = toSoA(m_sample.vectorProperties[slot]);
+		stats.addAllocations(m_sample.vectorProperties[slot].empty() ? 0 : 1);
+	}
+	else if(m_readMode == READ_COPY && (type == FLOAT || type == VECTOR))
+	{
+		AbcStatsTimer timer(stats, READ_COPY_OUT);
+		if(type == FLOAT)
 		{
-			m_arbGeoPropertiesMap.emplace(std::make_pair(std::get<0>(p), m_numArbGeoVectorProps));
-			++m_numArbGeoVectorProps;
+			copyView(m_arbGeoFloatProperties[slot], m_sample.floatProperties[slot], stats);
 		}
 		else
 		{
-			std::cout << "ERROR: Unrecognised Property Type. This will not be read! (" << std::get<0>(p) << ")" << std::endl;
+			copyView(m_arbGeoVectorProperties[slot], m_sample.vectorProperties[slot], stats);
 		}
 	}
+}
 
-	//print some debug stuff
-	std::cout << "Num Poly Mesh Schema Samples Read From file: " << schema.getNumSamples() << std::endl;
-	m_data->numSamples = schema.getNumSamples();
+void
+AbcReader::loadSample(int sampleIdx, AbcSample& sample)
+{
+	//a cache hit only swaps views, no alembic decode
+	if(m_cache && m_cache->find(sampleIdx, sample))
+	{
+		return;
+	}
 
-	//make sure to read the first sample into memory
-	sampleSpecific(0);
+	decodeSample(sampleIdx, sample);
+
+	if(m_cache)
+	{
+		m_cache->insert(sampleIdx, sample);
+	}
+}
+
+bool
+AbcReader::readTopology(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample)
+{
+	AbcReaderImp& data = *m_data;
+	Alembic::AbcGeom::IPolyMeshSchema& schema = data.mesh->getSchema();
+	Alembic::Abc::IInt32ArrayProperty faceIndicesProperty = schema.getFaceIndicesProperty();
+	Alembic::Abc::IInt32ArrayProperty faceCountsProperty = schema.getFaceCountsProperty();
+
+	//constant and homogeneous meshes never change their connectivity
+	const bool fixedTopology = data.topologyVariance != Alembic::AbcGeom::kHeterogenousTopology;
+
+	//otherwise compare the digests, which are available without reading the arrays
+	Alembic::Abc::ArraySampleKey faceIndicesKey;
+	Alembic::Abc::ArraySampleKey faceCountsKey;
+	const bool haveKeys = !fixedTopology && faceIndicesProperty.getKey(faceIndicesKey, sampleSelector)
+		&& faceCountsProperty.getKey(faceCountsKey, sampleSelector);
+
+	{
+		boost::unique_lock<boost::mutex> lock(data.topologyMutex);
+		if(data.topologyCached && (fixedTopology
+			|| (haveKeys && faceIndicesKey == data.faceIndicesKey && faceCountsKey == data.faceCountsKey)))
+		{
+			sample.faceIndices = data.faceIndices;
+			sample.faceCounts = data.faceCounts;
+			return false;
+		}
+	}
+
+	Alembic::Abc::Int32ArraySamplePtr faceIndices;
+	Alembic::Abc::Int32ArraySamplePtr faceCounts;
+	faceIndicesProperty.get(faceIndices, sampleSelector);
+	faceCountsProperty.get(faceCounts, sampleSelector);
+	sample.faceIndices = AbcArrayView<int>(faceIndices);
+	sample.faceCounts = AbcArrayView<int>(faceCounts);
 
+	if(fixedTopology || haveKeys)
+	{
+		boost::unique_lock<boost::mutex> lock(data.topologyMutex);
+		data.topologyCached = true;
+		data.faceIndicesKey = faceIndicesKey;
+		data.faceCountsKey = faceCountsKey;
+		data.faceIndices = sample.faceIndices;
+		data.faceCounts = sample.faceCounts;
+	}
 	return true;
 }
 
 void
-AbcReader::readCurrentSampleIntoMemory()
+AbcReader::decodeSample(int sampleIdx, AbcSample& sample)
 {
+	AbcStatsTimer decodeTimer(*m_stats, READ_DECODE);
+
 	//create a sample selector
-	Alembic::AbcGeom::ISampleSelector sampleSelector((Alembic::Abc::index_t)m_data->currentSample);
+	Alembic::AbcGeom::ISampleSelector sampleSelector((Alembic::Abc::index_t)sampleIdx);
+	sample.index = sampleIdx;
+
+	decodePositions(sampleSelector, sample);
+	decodeTopology(sampleSelector, sample);
+	decodeNormals(sampleSelector, sample);
+	decodeProperties(sampleSelector, sample);
 
-	//PREDEFINED_PROPERTIES-----------------------------------------------------
-	Alembic::AbcGeom::IPolyMeshSchema::Sample sample;
+	transposeSample(sample);
+}
+
+//PREDEFINED_PROPERTIES-----------------------------------------------------
+//the views keep the alembic buffers alive, nothing is copied here
+//every non-empty array is counted as a buffer alembic allocated for this sample
 
-	m_data->mesh->getSchema().get(sample, sampleSelector);
+void
+AbcReader::decodePositions(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample)
+{
+	AbcStatsTimer timer(*m_stats, READ_POSITIONS);
+	Alembic::AbcGeom::IPolyMeshSchema& schema = m_data->mesh->getSchema();
+	Alembic::Abc::P3fArraySamplePtr positions;
+	schema.getPositionsProperty().get(positions, sampleSelector);
+	sample.positions = AbcArrayView<Alembic::Abc::V3f>(positions);
 
-	//1. Positions
-	int numPositions = sample.getPositions()->size();
-	m_positions.resize(numPositions);
-	for (int i = 0; i < numPositions; ++i)
+	sample.velocities = AbcArrayView<Alembic::Abc::V3f>();
+	if(m_data->velocities.valid())
 	{
-		m_positions[i][0] = (*sample.getPositions())[i][0];
-		m_positions[i][1] = (*sample.getPositions())[i][1];
-		m_positions[i][2] = (*sample.getPositions())[i][2];
+		Alembic::Abc::V3fArraySamplePtr velocities;
+		m_data->velocities.get(velocities, sampleSelector);
+		sample.velocities = AbcArrayView<Alembic::Abc::V3f>(velocities);
 	}
 
-	//2. FaceIndices
-	int numFaceIndices = sample.getFaceIndices()->size();
-	m_faceIndices.resize(numFaceIndices);
-	Alembic::Abc::Int32ArraySamplePtr faceIndices = sample.getFaceIndices();
-	for (int i = 0; i < numFaceIndices; ++i)
+	sample.selfBounds = Alembic::Abc::Box3d();
+	Alembic::Abc::IBox3dProperty selfBounds = schema.getSelfBoundsProperty();
+	if(selfBounds.valid())
 	{
-		m_faceIndices[i] = (*faceIndices)[i];
+		selfBounds.get(sample.selfBounds, sampleSelector);
 	}
 
-	//3. FaceCounts
-	int numFaceCounts = sample.getFaceCounts()->size();
-	m_faceCounts.resize(numFaceCounts);
-	Alembic::Abc::Int32ArraySamplePtr faceCounts = sample.getFaceCounts();
-	for (int i = 0; i < numFaceCounts; ++i)
+	if(m_stats->isEnabled())
 	{
-		m_faceCounts[i]= (*faceCounts)[i];
+		m_stats->addBytesRead((sample.positions.size() + sample.velocities.size()) * sizeof(Alembic::Abc::V3f));
+		m_stats->addAllocations((sample.positions.empty() ? 0 : 1) + (sample.velocities.empty() ? 0 : 1));
 	}
+}
+
+void
+AbcReader::decodeTopology(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample)
+{
+	AbcStatsTimer timer(*m_stats, READ_TOPOLOGY);
 
-	//std::cout << "Reading Normals..." << std::endl;
-	//NORMALS -----------------------------------------------------------------
-	for(size_t i = 0; i < m_data->mesh->getSchema().getNumProperties(); ++i)
+	//cached topology is not read again
+	if(readTopology(sampleSelector, sample) && m_stats->isEnabled())
 	{
-		const Alembic::AbcGeom::PropertyHeader& header = m_data->mesh->getSchema().getPropertyHeader(i);
-		const std::string& name = header.getName();
+		m_stats->addBytesRead((sample.faceIndices.size() + sample.faceCounts.size()) * sizeof(int));
+		m_stats->addAllocations(2);
+	}
+}
 
-		if(name == "N")
-		{
-			Alembic::AbcGeom::IV3fGeomParam param(m_data->mesh->getSchema(), name);
-			Alembic::AbcGeom::IV3fGeomParam::prop_type::sample_ptr_type valuePtr = param.getExpandedValue(sampleSelector).getVals();
+//NORMALS -----------------------------------------------------------------
+void
+AbcReader::decodeNormals(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample)
+{
+	AbcStatsTimer timer(*m_stats, READ_NORMALS);
+	if(generatesNormals())
+	{
+		sample.normals = m_data->normalGenerator.compute(sample.positions, sample.faceIndices, sample.faceCounts, m_generatedNormalsScope);
+		return;
+	}
 
-			m_normals.resize(valuePtr->size());
-			for(size_t j = 0; j < valuePtr->size(); ++j)
-			{
-				m_normals[j][0] = valuePtr->get()[j][0];
-				m_normals[j][1] = valuePtr->get()[j][1];
-				m_normals[j][2] = valuePtr->get()[j][2];
-			}
-		}
+	sample.normals = m_data->hasNormals ?
+		AbcArrayView<Alembic::Abc::V3f>(m_data->normals.getExpandedValue(sampleSelector).getVals()) : AbcArrayView<Alembic::Abc::V3f>();
+	if(m_stats->isEnabled())
+	{
+		m_stats->addBytesRead(sample.normals.size() * sizeof(Alembic::Abc::V3f));
+		m_stats->addAllocations(sample.normals.empty() ? 0 : 1);
 	}
+}
+
+//CUSTOM PROPERTIES--------------------------------------------------------
+void
+AbcReader::decodeProperties(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample)
+{
+	AbcStats& stats = *m_stats;
+	AbcStatsTimer timer(stats, READ_PROPERTIES);
 
-	//std::cout << "Parsing Custom Params..." << std::endl;
-	//CUSTOM PROPERTIES--------------------------------------------------------
-	Alembic::AbcGeom::ICompoundProperty arbGeomPs = m_data->mesh->getSchema().getArbGeomParams();
-	//loop over properties, find the ones we want (this is a safety to make sure properties exist!)
-	//could lose the loop easily for clarity and performance
-	std::vector<Alembic::AbcGeom::IFloatGeomParam::prop_type::sample_ptr_type> floatSampleVals(m_numArbGeoFloatProps);
-	std::vector<Alembic::AbcGeom::IV3fGeomParam::prop_type::sample_ptr_type> vectorSampleVals(m_numArbGeoVectorProps);
-	for(size_t i = 0; i < arbGeomPs.getNumProperties(); ++i)
+	//missing properties stay empty
+	resetAllProperties(sample, m_numProperties);
+	for(auto& property : m_data->properties)
 	{
-		const Alembic::AbcGeom::PropertyHeader& header = arbGeomPs.getPropertyHeader(i);
-		const std::string& name = header.getName();
+		property->read(sampleSelector, sample, m_expandIndexed);
+	}
 
-		for(auto& p_map : m_arbGeoPropertiesMap)
+	if(stats.isEnabled())
+	{
+		uint64_t bytes = 0;
+		uint64_t buffers = 0;
+		countProperties<float>(sample, bytes, buffers);
+		countProperties<Alembic::Abc::V3f>(sample, bytes, buffers);
+		countProperties<int>(sample, bytes, buffers);
+		countProperties<Alembic::Abc::V2f>(sample, bytes, buffers);
+		countProperties<Alembic::Abc::Quatf>(sample, bytes, buffers);
+		countProperties<std::string>(sample, bytes, buffers);
+		for(auto& type : sample.propertyIndices)
 		{
-			if(p_map.first == name)
+			for(auto& indices : type)
 			{
-				if(Alembic::AbcGeom::IFloatGeomParam::matches(header))
-				{
-					Alembic::AbcGeom::IFloatGeomParam param(arbGeomPs, name);
-					floatSampleVals[p_map.second] = param.getExpandedValue(sampleSelector).getVals();
-					//std::cout << "Found float param: " << name << std::endl;
-				}
-				else if (Alembic::AbcGeom::IV3fGeomParam::matches(header) || Alembic::AbcGeom::IC3fGeomParam::matches(header))
-				{
-					Alembic::AbcGeom::IV3fGeomParam param(arbGeomPs, name);
-					vectorSampleVals[p_map.second] = param.getExpandedValue(sampleSelector).getVals();
-					//std::cout << "Found vector param: " << name << std::endl;
-				}
+				bytes += indices.size() * sizeof(uint32_t);
+				buffers += indices.empty() ? 0 : 1;
 			}
 		}
+		stats.addBytesRead(bytes);
+		stats.addAllocations(buffers);
+	}
+}
+
+void
+AbcReader::transposeSample(AbcSample& sample)
+{
+	if(m_readMode != READ_SOA)
+	{
+		sample.positionsSoA = AbcSoAVector3();
+		sample.normalsSoA = AbcSoAVector3();
+		sample.vectorPropertiesSoA.clear();
+		return;
 	}
 
-	//std::cout << "Reading floats params..." << std::endl;
-	//now parse values
+	//one aligned allocation per attribute, straight from the decoded alembic buffer
+	AbcStatsTimer timer(*m_stats, READ_TRANSPOSE);
+	sample.positionsSoA = toSoA(sample.positions);
+	sample.normalsSoA = toSoA(sample.normals);
+	sample.vectorPropertiesSoA.resize(sample.vectorProperties.size());
+	uint64_t buffers = (sample.positions.empty() ? 0 : 1) + (sample.normals.empty() ? 0 : 1);
+	for(size_t i = 0; i < sample.vectorProperties.size(); ++i)
+	{
+		sample.vectorPropertiesSoA[i] = toSoA(sample.vectorProperties[i]);
+		buffers += sample.vectorProperties[i].empty() ? 0 : 1;
+	}
+	m_stats->addAllocations(buffers);
+}
+
+void
+AbcReader::copySampleIntoMemory(bool copyTopology)
+{
+	AbcStatsTimer timer(*m_stats, READ_COPY_OUT);
+
+	copyView(m_positions, m_sample.positions, *m_stats);
+	if(copyTopology)
+	{
+		copyView(m_faceIndices, m_sample.faceIndices, *m_stats);
+		copyView(m_faceCounts, m_sample.faceCounts, *m_stats);
+	}
+	copyView(m_normals, m_sample.normals, *m_stats);
+	copyView(m_velocities, m_sample.velocities, *m_stats);
 
 	//for float properties
-	m_arbGeoFloatProperties.resize(floatSampleVals.size());
-	for(size_t i = 0; i < floatSampleVals.size(); ++i)
+	m_arbGeoFloatProperties.resize(m_sample.floatProperties.size());
+	for(size_t i = 0; i < m_sample.floatProperties.size(); ++i)
 	{
-		m_arbGeoFloatProperties[i].resize(floatSampleVals[i]->size());
-		for(size_t j = 0; j < floatSampleVals[i]->size(); ++j)
-		{
-			m_arbGeoFloatProperties[i][j] = floatSampleVals[i]->get()[j];
-		}
+		copyView(m_arbGeoFloatProperties[i], m_sample.floatProperties[i], *m_stats);
 	}
 
-	//std::cout << "Reading Vector params..." << std::endl;	
 	//for vector properties
-	m_arbGeoVectorProperties.resize(vectorSampleVals.size());
-	for(size_t i = 0; i < vectorSampleVals.size(); ++i)
+	m_arbGeoVectorProperties.resize(m_sample.vectorProperties.size());
+	for(size_t i = 0; i < m_sample.vectorProperties.size(); ++i)
 	{
-		m_arbGeoVectorProperties[i].resize(vectorSampleVals[i]->size());
-		for(size_t j = 0; j < vectorSampleVals[i]->size(); ++j)
-		{
-			m_arbGeoVectorProperties[i][j][0] = vectorSampleVals[i]->get()[j][0];
-			m_arbGeoVectorProperties[i][j][1] = vectorSampleVals[i]->get()[j][1];
-			m_arbGeoVectorProperties[i][j][2] = vectorSampleVals[i]->get()[j][2];
-		}
+		copyView(m_arbGeoVectorProperties[i], m_sample.vectorProperties[i], *m_stats);
 	}
 }
 
 bool
 AbcReader::sampleForward()
 {
-	if (m_data->currentSample < m_data->numSamples)
+	if (m_data->currentSample + 1 < m_data->numSamples)
 	{
 		m_data->currentSample += 1;
-		readCurrentSampleIntoMemory();
+		readCurrentSampleIntoMemory(1);
 		return true;
 	}
 	else
@@ -234,10 +1199,10 @@ AbcReader::sampleForward()
 bool
 AbcReader::sampleBackward()
 {
-	if (m_data->currentSample >= 0)
+	if (m_data->currentSample > 0)
 	{
 		m_data->currentSample -= 1;
-		readCurrentSampleIntoMemory();
+		readCurrentSampleIntoMemory(-1);
 		return true;
 	}
 	else
@@ -261,8 +1226,203 @@ AbcReader::sampleSpecific(int sample)
 	}
 }
 
+void
+AbcReader::loadTimeSample(int sampleIdx, AbcSample& sample)
+{
+	//queries between the same two samples decode nothing, stepping forward turns the old ceil into the new floor
+	if(m_timeFloor.index == sampleIdx)
+	{
+		sample = m_timeFloor;
+	}
+	else if(m_timeCeil.index == sampleIdx)
+	{
+		sample = m_timeCeil;
+	}
+	else
+	{
+		loadSample(sampleIdx, sample);
+	}
+}
+
+bool
+AbcReader::sampleAtTime(double time, INTERPOLATION_MODE mode)
+{
+	AbcReaderImp& data = *m_data;
+	if(data.numSamples <= 0 || !data.timeSampling)
+	{
+		return false;
+	}
+	AbcStatsTimer timer(*m_stats, READ_SAMPLE);
+
+	//jumping: whatever was prefetched is useless now
+	if(m_prefetcher)
+	{
+		m_prefetcher->cancel();
+	}
+
+	const Alembic::Abc::index_t numSamples = data.numSamples;
+	const int floorIdx = (int)Alembic::Abc::ISampleSelector(time, Alembic::Abc::ISampleSelector::kFloorIndex).getIndex(data.timeSampling, numSamples);
+	const int ceilIdx = (int)Alembic::Abc::ISampleSelector(time, Alembic::Abc::ISampleSelector::kCeilIndex).getIndex(data.timeSampling, numSamples);
+
+	AbcSample floorSample;
+	AbcSample ceilSample;
+	loadTimeSample(floorIdx, floorSample);
+	loadTimeSample(ceilIdx, ceilSample);
+	m_timeFloor = floorSample;
+	m_timeCeil = ceilSample;
+
+	AbcArrayView<int> previousFaceIndices;
+	AbcArrayView<int> previousFaceCounts;
+	lastTopology(previousFaceIndices, previousFaceCounts);
+	m_pendingParts = 0;
+	forgetCopies();
+	m_previousFaceIndices = AbcArrayView<int>();
+	m_previousFaceCounts = AbcArrayView<int>();
+	m_sample = floorSample;
+	data.currentSample = floorIdx;
+
+	//on a sample, or clamped outside the sampled range
+	const double floorTime = data.timeSampling->getSampleTime(floorIdx);
+	const double ceilTime = data.timeSampling->getSampleTime(ceilIdx);
+	if(mode != INTERPOLATE_NONE && floorIdx != ceilIdx && time > floorTime && ceilTime > floorTime)
+	{
+		AbcStatsTimer interpolateTimer(*m_stats, READ_INTERPOLATE);
+
+		const size_t numPoints = floorSample.positions.size();
+		const bool canBlend = ceilSample.positions.size() == numPoints
+			&& sameContents(floorSample.faceCounts, ceilSample.faceCounts) && sameContents(floorSample.faceIndices, ceilSample.faceIndices);
+		const bool canAdvect = floorSample.velocities.size() == numPoints;
+		const bool blend = canBlend && (mode == INTERPOLATE_LINEAR || !canAdvect);
+
+		if(numPoints > 0 && (blend || canAdvect))
+		{
+			std::vector<Alembic::Abc::V3f> positions(numPoints);
+			if(blend)
+			{
+				lerpPoints(floorSample.positions.data(), ceilSample.positions.data(),
+					(float)((time - floorTime) / (ceilTime - floorTime)), numPoints, positions.data());
+			}
+			else
+			{
+				advectPoints(floorSample.positions.data(), floorSample.velocities.data(), (float)(time - floorTime), numPoints, positions.data());
+			}
+			m_sample.positions = AbcArrayView<Alembic::Abc::V3f>::adopt(std::move(positions));
+			m_stats->addAllocations(1);
+
+			//the stored bounds belong to the earlier sample
+			m_sample.selfBounds = computeBounds(m_sample.positions);
+			if(m_readMode == READ_SOA)
+			{
+				m_sample.positionsSoA = toSoA(m_sample.positions);
+				m_stats->addAllocations(1);
+			}
+		}
+	}
+
+	m_topologyChanged = topologyDiffers(m_sample, previousFaceIndices, previousFaceCounts);
+	if(m_readMode == READ_COPY)
+	{
+		copySampleIntoMemory(m_topologyChanged);
+	}
+	return true;
+}
+
+double
+AbcReader::getSampleTime(int sample)
+{
+	return m_data->timeSampling ? m_data->timeSampling->getSampleTime(sample) : 0.0;
+}
+
 int
 AbcReader::getNumSamples()
 {
 	return m_data->numSamples;
-}
\ No newline at end of file
+}
+
+void
+AbcReader::setPrefetchDepth(int depth)
+{
+	if(depth <= 0)
+	{
+		m_prefetcher.reset();
+	}
+	else if(m_prefetcher)
+	{
+		m_prefetcher->setDepth(depth);
+	}
+	else
+	{
+		m_prefetcher = std::make_shared<AbcPrefetcher>(
+			[this](int sampleIdx, AbcSample& sample) { loadSample(sampleIdx, sample); }, depth);
+	}
+}
+
+int
+AbcReader::getPrefetchDepth()
+{
+	return m_prefetcher ? m_prefetcher->getDepth() : 0;
+}
+
+void
+AbcReader::cancelPrefetch(bool waitForWorker)
+{
+	if(m_prefetcher)
+	{
+		m_prefetcher->cancel(waitForWorker);
+	}
+}
+
+void
+AbcReader::setCacheBudget(size_t bytes)
+{
+	if(bytes == 0)
+	{
+		//the prefetch worker reads through the cache
+		cancelPrefetch(true);
+		m_cache.reset();
+	}
+	else if(m_cache)
+	{
+		m_cache->setBudget(bytes);
+	}
+	else
+	{
+		cancelPrefetch(true);
+		m_cache = std::make_shared<AbcSampleCache>(bytes);
+	}
+}
+
+AbcCacheStats
+AbcReader::getCacheStats()
+{
+	if(m_cache)
+	{
+		return m_cache->getStats();
+	}
+
+	AbcCacheStats stats = AbcCacheStats();
+	return stats;
+}
+
+void
+AbcReader::readRange(int begin, int end, const std::function<void(const AbcSample&)>& callback, bool inOrder)
+{
+	begin = std::max(begin, 0);
+	end = std::min(end, m_data->numSamples);
+	if(begin >= end)
+	{
+		return;
+	}
+
+	//the callback always runs on the calling thread, one sample at a time
+	AbcThreadPool::defaultPool().orderedPrefetch<AbcSample>((size_t)(end - begin), 0,
+		[&](size_t i, AbcSample& sample)
+		{
+			loadSample(begin + (int)i, sample);
+		},
+		[&](size_t, AbcSample& sample)
+		{
+			callback(sample);
+			return true;
+		}, inOrder);
+}
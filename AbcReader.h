@@ -3,10 +3,20 @@
 #include <string>
 #include <vector>
 #include <tuple>
+#include <unordered_map>
+#include <functional>
 
 #include <Alembic/Abc/All.h>
 
 #include "easyAbcUtil.h"
+#include "AbcSample.h"
+#include "AbcProperty.h"
+#include "AbcPrefetcher.h"
+#include "AbcSampleCache.h"
+#include "AbcStats.h"
+#include "AbcTriangulation.h"
+#include "AbcArchivePool.h"
+#include "AbcArchiveIndex.h"
 
 struct AbcReaderImp;
 
@@ -19,39 +29,265 @@ public:
 	bool openArchive(const std::string& file, const std::string& xFormName, const std::string& meshName,
 		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties);
 
+	//! Bind to a mesh of an archive that is already open (shared with other readers)
+	bool openArchive(const std::shared_ptr<Alembic::Abc::IArchive>& archive, const std::string& xFormName,
+		const std::string& meshName, const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties);
+
+	//! Bind to the mesh at meshPath of an indexed archive, at any depth, without looking it up again
+	bool openArchive(const AbcArchiveIndex& index, const std::string& meshPath,
+		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties);
+
 	bool sampleForward();
 	bool sampleBackward();
 	bool sampleSpecific(int sample);
 
+	//! Positions at time (seconds), everything else comes from the sample at or before it. The samples on either side are
+	//! decoded once and kept while queries stay between them. INTERPOLATE_LINEAR blends them if their topology matches,
+	//! INTERPOLATE_VELOCITY moves the earlier sample's points along its velocities. Each falls back to the other,
+	//! then to the earlier sample as is. Times outside the sampled range clamp to the first or last sample.
+	bool sampleAtTime(double time, INTERPOLATION_MODE mode = INTERPOLATE_LINEAR);
+	//! Time of a sample in seconds
+	double getSampleTime(int sample);
+
+	//! Ogawa streams opened by openArchive(file, ...), more streams let samples decode concurrently
+	void setNumStreams(size_t numStreams) { m_numStreams = numStreams; }
+	//! Let openArchive(file, ...) share the archive of pool (e.g. AbcArchivePool::defaultPool()) with other readers
+	//! of the same file instead of opening its own. The pool's stream count applies then. nullptr = own archive.
+	void setArchivePool(AbcArchivePool* pool) { m_archivePool = pool; }
+
+	//! Decode samples [begin, end) concurrently on the default thread pool and hand each to callback.
+	//! inOrder delivers them by sample index, otherwise as soon as they are decoded.
+	//! callback runs on the calling thread, one sample at a time. The current sample is left alone.
+	void readRange(int begin, int end, const std::function<void(const AbcSample&)>& callback, bool inOrder = true);
+
 	int getNumSamples();
 
-	int getNumFaces() { return m_faceCounts.size(); }
+	//! Decode up to depth samples ahead of sampleForward/sampleBackward on a worker thread (0 = off)
+	void setPrefetchDepth(int depth);
+	int getPrefetchDepth();
+	//! Drop all prefetched samples (sampleSpecific does this automatically)
+	void cancelPrefetch(bool waitForWorker = false);
+
+	//! Keep decoded samples in an LRU cache of at most bytes (0 = off), so scrubbing back
+	//! to a sample that was already viewed does not decode it again
+	void setCacheBudget(size_t bytes);
+	AbcCacheStats getCacheStats();
+
+	//! Per-phase timings, latency histograms, bytes read and allocations, including prefetch and readRange decodes
+	AbcStatsSnapshot getStats() const { return m_stats->snapshot(); }
+	void resetStats() { m_stats->reset(); }
+	void setStatsEnabled(bool enabled) { m_stats->setEnabled(enabled); }
+	//! Print the stats to std::cout every seconds while samples are read (0 = off)
+	void setStatsDumpInterval(double seconds) { m_stats->setDumpInterval(seconds); }
+
+	int getNumFaces() { require(LAZY_TOPOLOGY); return m_sample.faceCounts.size(); }
+
+	//! Fan triangulation of the current sample, only rebuilt when the topology changes. nullptr for broken topology.
+	std::shared_ptr<const AbcTriangulation> getTriangulation();
+
+	//! values (per point for POINT/VERTEX scope, per face corner for FACE) gathered onto the corners of getTriangulation()
+	template <typename T>
+	AbcArrayView<T> getTriangleAttribute(const AbcArrayView<T>& values, PROP_SCOPE scope)
+	{
+		std::shared_ptr<const AbcTriangulation> triangulation = getTriangulation();
+		require(LAZY_POSITIONS);
+		return triangulation ? expandToTriangles(values, scope, *triangulation, m_sample.positions.size()) : AbcArrayView<T>();
+	}
+
+	//! Bounds of the current sample as stored in the archive, for culling without touching the positions
+	const Alembic::Abc::Box3d& getSelfBounds() const { require(LAZY_POSITIONS); return m_sample.selfBounds; }
+
+	//! True if faceIndices/faceCounts differ from the previously loaded sample.
+	//! Unchanged topology is not re-read or re-copied, so index buffers built from it can be kept.
+	bool topologyChanged() const { require(LAZY_TOPOLOGY); return m_topologyChanged; }
+
+	//! READ_VIEW (default) only keeps references to the decoded Alembic buffers (the copy accessors below copy on first use),
+	//! READ_COPY additionally copies them into the mutable vectors below while decoding,
+	//! READ_SOA additionally de-interleaves positions, normals and vector properties while decoding
+	void setReadMode(READ_MODE mode);
+	READ_MODE getReadMode() const { return m_readMode; }
 
-	//Data Accessors
-	std::vector<Alembic::Abc::V3f>& getPositions() { return m_positions; }
-	std::vector<int>& getFaceIndices() { return m_faceIndices; }
-	std::vector<int>& getFaceCounts() { return m_faceCounts; }
-	std::vector<Alembic::Abc::V3f>& getNormals() { return m_normals; }
+	//! Generate normals of scope from the positions and topology when N is missing (or always, if it is stale).
+	//! They are computed while decoding, with the face adjacency reused until the topology changes.
+	void setNormalsMode(NORMALS_MODE mode, PROP_SCOPE scope = POINT);
+	NORMALS_MODE getNormalsMode() const { return m_normalsMode; }
+
+	//! Indexed GeomParams are expanded to one value per element by default. Without expanding, getProperty returns
+	//! their unique values and getPropertyIndices an index per element into them, saving the gather and its memory.
+	void setExpandIndexedProperties(bool expand);
+	bool getExpandIndexedProperties() const { return m_expandIndexed; }
+
+	//! Stepping to a sample only remembers it, nothing is decoded. Positions (with velocities and bounds), topology,
+	//! normals and each property are decoded the first time an accessor below asks for them, once per sample.
+	//! Samples found in the cache arrive fully decoded. Lazily decoded samples are not cached and not prefetched,
+	//! prefetching would decode everything. Accessors then modify the reader, do not call them concurrently.
+	void setLazyDecode(bool lazy);
+	bool getLazyDecode() const { return m_lazy; }
+
+	//Zero-copy Data Accessors
+	const AbcSample& getSample() const { require(LAZY_ALL); return m_sample; }
+	const AbcArrayView<Alembic::Abc::V3f>& getPositionsView() const { require(LAZY_POSITIONS); return m_sample.positions; }
+	const AbcArrayView<int>& getFaceIndicesView() const { require(LAZY_TOPOLOGY); return m_sample.faceIndices; }
+	const AbcArrayView<int>& getFaceCountsView() const { require(LAZY_TOPOLOGY); return m_sample.faceCounts; }
+	const AbcArrayView<Alembic::Abc::V3f>& getNormalsView() const { require(LAZY_NORMALS); return m_sample.normals; }
+	const AbcArrayView<Alembic::Abc::V3f>& getVelocitiesView() const { require(LAZY_POSITIONS); return m_sample.velocities; }
+
+	//SoA Data Accessors (only filled in READ_SOA mode), 64 byte aligned x, y, z buffers
+	const AbcSoAVector3& getPositionsSoA() const { require(LAZY_POSITIONS); return m_sample.positionsSoA; }
+	const AbcSoAVector3& getNormalsSoA() const { require(LAZY_NORMALS); return m_sample.normalsSoA; }
+	const AbcSoAVector3& getVectorPropertySoA(const AbcPropertyHandle<Alembic::Abc::V3f>& handle) const
+	{
+		static const AbcSoAVector3 empty;
+		requireProperty(VECTOR, handle.slot());
+		const std::vector<AbcSoAVector3>& properties = m_sample.vectorPropertiesSoA;
+		return handle.valid() && handle.slot() < (int)properties.size() ? properties[handle.slot()] : empty;
+	}
+
+	const AbcArrayView<float>& getFloatPropertyView(const std::string& name);
+	const AbcArrayView<Alembic::Abc::V3f>& getVectorPropertyView(const std::string& name);
+
+	//! Resolve a declared property once. T is float, V3f, int, V2f, Quatf or std::string.
+	//! Returns an invalid handle if name was not declared with that type.
+	template <typename T>
+	AbcPropertyHandle<T> getPropertyHandle(const std::string& name) const
+	{
+		auto it = m_propertySlots.find(name);
+		if(it == m_propertySlots.end() || it->second.first != AbcPropertyTraits<T>::type)
+		{
+			return AbcPropertyHandle<T>();
+		}
+		return AbcPropertyHandle<T>(it->second.second);
+	}
+
+	//! Names of the declared properties of type, in slot order
+	std::vector<std::string> getPropertyNames(PROP_TYPE type) const;
+
+	//! O(1) per-sample access through a handle, empty if the property is missing in the file
+	template <typename T>
+	const AbcArrayView<T>& getProperty(const AbcPropertyHandle<T>& handle) const
+	{
+		static const AbcArrayView<T> empty;
+		requireProperty(AbcPropertyTraits<T>::type, handle.slot());
+		const std::vector<AbcArrayView<T>>& properties = m_sample.getProperties<T>();
+		return handle.valid() && handle.slot() < (int)properties.size() ? properties[handle.slot()] : empty;
+	}
+
+	//! Per element indices into getProperty, empty if the property is not indexed or indexed properties are expanded
+	template <typename T>
+	const AbcArrayView<uint32_t>& getPropertyIndices(const AbcPropertyHandle<T>& handle) const
+	{
+		static const AbcArrayView<uint32_t> empty;
+		const std::vector<std::vector<AbcArrayView<uint32_t>>>& indices = m_sample.propertyIndices;
+		const PROP_TYPE type = AbcPropertyTraits<T>::type;
+		requireProperty(type, handle.slot());
+		return handle.valid() && type < (int)indices.size() && handle.slot() < (int)indices[type].size() ?
+			indices[type][handle.slot()] : empty;
+	}
+
+	//Copy Data Accessors (filled while decoding in READ_COPY mode, in the other modes once per sample on first use)
+	std::vector<Alembic::Abc::V3f>& getPositions() { requireCopy(LAZY_POSITIONS); return m_positions; }
+	std::vector<int>& getFaceIndices() { requireCopy(LAZY_TOPOLOGY); return m_faceIndices; }
+	std::vector<int>& getFaceCounts() { requireCopy(LAZY_TOPOLOGY); return m_faceCounts; }
+	std::vector<Alembic::Abc::V3f>& getNormals() { requireCopy(LAZY_NORMALS); return m_normals; }
+	std::vector<Alembic::Abc::V3f>& getVelocities() { requireCopy(LAZY_POSITIONS); return m_velocities; }
 
 	std::vector<float>& getFloatProperty(const std::string& name);
 	std::vector<Alembic::Abc::V3f>& getVectorProperty(const std::string& name);
 
 private:
+	friend class AbcSceneReader;
+
+	//parts of a lazily stepped sample that have not been decoded yet
+	enum LazyPart
+	{
+		LAZY_POSITIONS = 1,
+		LAZY_TOPOLOGY = 2,
+		LAZY_NORMALS = 4,
+		LAZY_PROPERTIES = 8,
+		LAZY_ALL = 15,
+	};
 
-	void readCurrentSampleIntoMemory();
+	//decoding on first access only fills in the memoized sample, the const accessors stay const to callers
+	void require(unsigned parts) const
+	{
+		if(m_pendingParts & parts)
+		{
+			const_cast<AbcReader*>(this)->decodePending(parts);
+		}
+	}
+	void requireProperty(PROP_TYPE type, int slot) const
+	{
+		if(m_pendingParts & LAZY_PROPERTIES)
+		{
+			const_cast<AbcReader*>(this)->decodePendingProperty(type, slot);
+		}
+	}
+	void decodePending(unsigned parts);
+	void requireCopy(unsigned parts);
+	bool requireCopiedProperty(PROP_TYPE type, int slot);
+	void forgetCopies();
+	void decodePendingProperty(PROP_TYPE type, int slot);
+	void startLazySample();
+	void lastTopology(AbcArrayView<int>& faceIndices, AbcArrayView<int>& faceCounts) const;
+	bool generatesNormals() const;
+
+	bool bindMesh(const std::shared_ptr<Alembic::Abc::IArchive>& archive, const std::string& xFormName,
+		const std::string& meshName, const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties);
+	bool bindObject(const std::shared_ptr<Alembic::Abc::IArchive>& archive, const Alembic::Abc::IObject& meshObject,
+		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties);
+	void readCurrentSampleIntoMemory(int direction = 0);
+	void discardDecodedSamples();
+	void loadTimeSample(int sampleIdx, AbcSample& sample);
+	int findPropertySlot(const std::string& name, PROP_TYPE type) const;
+	void loadSample(int sampleIdx, AbcSample& sample);
+	void decodeSample(int sampleIdx, AbcSample& sample);
+	void decodePositions(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample);
+	void decodeTopology(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample);
+	bool readTopology(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample);
+	void decodeNormals(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample);
+	void decodeProperties(const Alembic::Abc::ISampleSelector& sampleSelector, AbcSample& sample);
+	void copySampleIntoMemory(bool copyTopology = true);
+	void transposeSample(AbcSample& sample);
 
 	std::shared_ptr<AbcReaderImp> m_data;
 
+	READ_MODE m_readMode;
+	NORMALS_MODE m_normalsMode;
+	PROP_SCOPE m_generatedNormalsScope;
+	bool m_expandIndexed;
+	bool m_lazy;
+	AbcSample m_sample;
+	//LazyPart bits and per type, per slot flags of properties m_sample still lacks
+	unsigned m_pendingParts;
+	std::vector<std::vector<bool>> m_pendingProperties;
+	//LazyPart bits and FLOAT/VECTOR slots of m_sample already copied out, outside READ_COPY
+	unsigned m_copiedParts;
+	std::vector<std::vector<bool>> m_copiedProperties;
+	//topology handed out before a lazy step, until the new one is decoded and compared against it
+	AbcArrayView<int> m_previousFaceIndices;
+	AbcArrayView<int> m_previousFaceCounts;
+	//samples around the last sampleAtTime query
+	AbcSample m_timeFloor;
+	AbcSample m_timeCeil;
+	bool m_topologyChanged;
+	size_t m_numStreams;
+	AbcArchivePool* m_archivePool;
+	std::shared_ptr<AbcSampleCache> m_cache;
+	std::shared_ptr<AbcPrefetcher> m_prefetcher;
+	std::shared_ptr<AbcStats> m_stats;
+
 	std::vector<Alembic::Abc::V3f> m_positions;
 	std::vector<Alembic::Abc::V3f> m_velocities;
 	std::vector<int> m_faceIndices;
 	std::vector<int> m_faceCounts;
 	std::vector<Alembic::Abc::V3f> m_normals;
 	//for arbitrary float properties added to the mesh
-	std::unordered_map<std::string, size_t> m_arbGeoPropertiesMap;
-	size_t m_numArbGeoFloatProps;
-	size_t m_numArbGeoVectorProps;
+	//declared name -> (type, slot within that type)
+	std::unordered_map<std::string, std::pair<PROP_TYPE, int>> m_propertySlots;
+	std::vector<size_t> m_numProperties;
 	std::vector<std::vector<float>> m_arbGeoFloatProperties;
 	std::vector<std::vector<Alembic::Abc::V3f>> m_arbGeoVectorProperties;
+	std::vector<float> m_missingFloatProperty;
+	std::vector<Alembic::Abc::V3f> m_missingVectorProperty;
 };
 
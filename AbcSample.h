@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <Alembic/Abc/All.h>
+
+//! Lightweight read-only view onto a contiguous array.
+//! The view keeps whatever owns the memory (usually an Alembic ArraySample) alive,
+//! so it stays valid after the reader has moved on to another sample.
+template <typename T>
+class AbcArrayView
+{
+public:
+	typedef T value_type;
+	typedef const T* const_iterator;
+
+	AbcArrayView() : m_data(nullptr), m_size(0) {}
+
+	AbcArrayView(const T* data, size_t size, const std::shared_ptr<const void>& owner = std::shared_ptr<const void>())
+		: m_data(data), m_size(size), m_owner(owner) {}
+
+	//! Non-owning view, the vector has to outlive the view
+	AbcArrayView(const std::vector<T>& v) : m_data(v.data()), m_size(v.size()) {}
+
+	//! Take ownership of a vector without copying its contents
+	static AbcArrayView adopt(std::vector<T>&& v)
+	{
+		std::shared_ptr<std::vector<T>> owner = std::make_shared<std::vector<T>>(std::move(v));
+		return AbcArrayView(owner->data(), owner->size(), owner);
+	}
+
+	//! Wrap an Alembic array sample without copying it (V3f/C3f/N3f/P3f share the same layout)
+	template <typename TRAITS>
+	explicit AbcArrayView(const std::shared_ptr<Alembic::Abc::TypedArraySample<TRAITS>>& sample)
+		: m_data(sample ? reinterpret_cast<const T*>(sample->get()) : nullptr),
+		m_size(sample ? sample->size() : 0),
+		m_owner(sample) {}
+
+	const T* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	const T& operator[](size_t i) const { return m_data[i]; }
+	const_iterator begin() const { return m_data; }
+	const_iterator end() const { return m_data + m_size; }
+
+	//! Copy into a mutable vector for callers that need to modify the data
+	std::vector<T> toVector() const { return std::vector<T>(begin(), end()); }
+
+	const std::shared_ptr<const void>& owner() const { return m_owner; }
+
+private:
+	const T* m_data;
+	size_t m_size;
+	std::shared_ptr<const void> m_owner;
+};
+
+//! True if both views hold the same values. Views sharing an owner are compared by address,
+//! a buffer kept alive by both cannot have been reused for other data.
+template <typename T>
+bool sameContents(const AbcArrayView<T>& a, const AbcArrayView<T>& b)
+{
+	if(a.size() != b.size())
+	{
+		return false;
+	}
+	if(a.data() == b.data() && a.owner() && a.owner() == b.owner())
+	{
+		return true;
+	}
+	return a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+//! De-interleaved V3f array, x, y and z each in their own 64 byte aligned buffer (see AbcSoA.h)
+struct AbcSoAVector3
+{
+	size_t size() const { return x.size(); }
+	bool empty() const { return x.empty(); }
+
+	AbcArrayView<float> x;
+	AbcArrayView<float> y;
+	AbcArrayView<float> z;
+};
+
+//! All data decoded for one mesh sample, held as views onto the Alembic buffers
+struct AbcSample
+{
+	AbcSample() : index(-1) {}
+
+	int index;
+
+	AbcArrayView<Alembic::Abc::V3f> positions;
+	AbcArrayView<int> faceIndices;
+	AbcArrayView<int> faceCounts;
+	AbcArrayView<Alembic::Abc::V3f> normals;
+	//units per second, empty if the file has none
+	AbcArrayView<Alembic::Abc::V3f> velocities;
+	//as stored in the archive, empty if the file has none
+	Alembic::Abc::Box3d selfBounds;
+
+	//indexed in declaration order, per property type
+	std::vector<AbcArrayView<float>> floatProperties;
+	std::vector<AbcArrayView<Alembic::Abc::V3f>> vectorProperties;
+	std::vector<AbcArrayView<int>> intProperties;
+	std::vector<AbcArrayView<Alembic::Abc::V2f>> vector2Properties;
+	std::vector<AbcArrayView<Alembic::Abc::Quatf>> quatProperties;
+	std::vector<AbcArrayView<std::string>> stringProperties;
+	//indexed by PROP_TYPE, then slot. Only filled for indexed properties read without expanding them,
+	//the property then holds the unique values and this one index per element into them.
+	std::vector<std::vector<AbcArrayView<uint32_t>>> propertyIndices;
+
+	//READ_SOA mode only, positions, normals and vector properties de-interleaved
+	AbcSoAVector3 positionsSoA;
+	AbcSoAVector3 normalsSoA;
+	std::vector<AbcSoAVector3> vectorPropertiesSoA;
+
+	//! The property list for element type T (float, V3f, int, V2f, Quatf or std::string)
+	template <typename T> std::vector<AbcArrayView<T>>& getProperties();
+	template <typename T> const std::vector<AbcArrayView<T>>& getProperties() const
+	{
+		return const_cast<AbcSample*>(this)->getProperties<T>();
+	}
+};
+
+template <> inline std::vector<AbcArrayView<float>>& AbcSample::getProperties<float>() { return floatProperties; }
+template <> inline std::vector<AbcArrayView<Alembic::Abc::V3f>>& AbcSample::getProperties<Alembic::Abc::V3f>() { return vectorProperties; }
+template <> inline std::vector<AbcArrayView<int>>& AbcSample::getProperties<int>() { return intProperties; }
+template <> inline std::vector<AbcArrayView<Alembic::Abc::V2f>>& AbcSample::getProperties<Alembic::Abc::V2f>() { return vector2Properties; }
+template <> inline std::vector<AbcArrayView<Alembic::Abc::Quatf>>& AbcSample::getProperties<Alembic::Abc::Quatf>() { return quatProperties; }
+template <> inline std::vector<AbcArrayView<std::string>>& AbcSample::getProperties<std::string>() { return stringProperties; }
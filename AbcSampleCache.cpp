@@ -0,0 +1,162 @@
+#include "AbcSampleCache.h"
+
+AbcSampleCache::AbcSampleCache(size_t budgetBytes) : m_budget(budgetBytes), m_bytes(0), m_hits(0), m_misses(0), m_evictions(0)
+{
+}
+
+void AbcSampleCache::setBudget(size_t budgetBytes)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_budget = budgetBytes;
+	evict();
+}
+
+bool AbcSampleCache::find(int sampleIdx, AbcSample& sample)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	auto it = m_index.find(sampleIdx);
+	if(it == m_index.end())
+	{
+		++m_misses;
+		return false;
+	}
+
+	++m_hits;
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	sample = it->second->second;
+	return true;
+}
+
+void AbcSampleCache::insert(int sampleIdx, const AbcSample& sample)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	if(m_index.find(sampleIdx) != m_index.end())
+	{
+		return;
+	}
+
+	m_entries.push_front(std::make_pair(sampleIdx, sample));
+	m_index[sampleIdx] = m_entries.begin();
+	addBuffers(sample, 1);
+	evict();
+}
+
+void AbcSampleCache::clear()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_entries.clear();
+	m_index.clear();
+	m_buffers.clear();
+	m_bytes = 0;
+}
+
+AbcCacheStats AbcSampleCache::getStats()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	AbcCacheStats stats;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.evictions = m_evictions;
+	stats.numSamples = m_entries.size();
+	stats.bytes = m_bytes;
+	stats.budget = m_budget;
+	return stats;
+}
+
+void AbcSampleCache::resetStats()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_hits = 0;
+	m_misses = 0;
+	m_evictions = 0;
+}
+
+template <typename T>
+static void countBuffer(std::unordered_map<const void*, std::pair<size_t, size_t>>& buffers, size_t& bytes,
+	const AbcArrayView<T>& view, int delta)
+{
+	if(view.empty())
+	{
+		return;
+	}
+
+	std::pair<size_t, size_t>& entry = buffers[view.data()];
+	if(delta > 0)
+	{
+		if(entry.first++ == 0)
+		{
+			entry.second = view.size() * sizeof(T);
+			bytes += entry.second;
+		}
+	}
+	else if(--entry.first == 0)
+	{
+		bytes -= entry.second;
+		buffers.erase(view.data());
+	}
+}
+
+static void countSoA(std::unordered_map<const void*, std::pair<size_t, size_t>>& buffers, size_t& bytes,
+	const AbcSoAVector3& soa, int delta)
+{
+	countBuffer(buffers, bytes, soa.x, delta);
+	countBuffer(buffers, bytes, soa.y, delta);
+	countBuffer(buffers, bytes, soa.z, delta);
+}
+
+void AbcSampleCache::addBuffers(const AbcSample& sample, int delta)
+{
+	countBuffer(m_buffers, m_bytes, sample.positions, delta);
+	countBuffer(m_buffers, m_bytes, sample.faceIndices, delta);
+	countBuffer(m_buffers, m_bytes, sample.faceCounts, delta);
+	countBuffer(m_buffers, m_bytes, sample.normals, delta);
+	countBuffer(m_buffers, m_bytes, sample.velocities, delta);
+	for(auto& p : sample.floatProperties)
+	{
+		countBuffer(m_buffers, m_bytes, p, delta);
+	}
+	for(auto& p : sample.vectorProperties)
+	{
+		countBuffer(m_buffers, m_bytes, p, delta);
+	}
+	for(auto& p : sample.intProperties)
+	{
+		countBuffer(m_buffers, m_bytes, p, delta);
+	}
+	for(auto& p : sample.vector2Properties)
+	{
+		countBuffer(m_buffers, m_bytes, p, delta);
+	}
+	for(auto& p : sample.quatProperties)
+	{
+		countBuffer(m_buffers, m_bytes, p, delta);
+	}
+	for(auto& p : sample.stringProperties)
+	{
+		countBuffer(m_buffers, m_bytes, p, delta);
+	}
+	for(auto& type : sample.propertyIndices)
+	{
+		for(auto& indices : type)
+		{
+			countBuffer(m_buffers, m_bytes, indices, delta);
+		}
+	}
+	countSoA(m_buffers, m_bytes, sample.positionsSoA, delta);
+	countSoA(m_buffers, m_bytes, sample.normalsSoA, delta);
+	for(auto& p : sample.vectorPropertiesSoA)
+	{
+		countSoA(m_buffers, m_bytes, p, delta);
+	}
+}
+
+void AbcSampleCache::evict()
+{
+	while(m_bytes > m_budget && !m_entries.empty())
+	{
+		addBuffers(m_entries.back().second, -1);
+		m_index.erase(m_entries.back().first);
+		m_entries.pop_back();
+		++m_evictions;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include <boost/thread/mutex.hpp>
+
+#include "AbcSample.h"
+
+struct AbcCacheStats
+{
+	size_t hits;
+	size_t misses;
+	size_t evictions;
+	size_t numSamples;
+	size_t bytes;
+	size_t budget;
+};
+
+//! Decoded samples keyed by sample index, evicted least-recently-used first once the byte budget is exceeded.
+//! Buffers shared between samples (e.g. cached topology) are only counted once.
+class AbcSampleCache
+{
+public:
+	explicit AbcSampleCache(size_t budgetBytes);
+
+	void setBudget(size_t budgetBytes);
+
+	//! Copies the cached views into sample and marks it most recently used. Counts a hit or a miss.
+	bool find(int sampleIdx, AbcSample& sample);
+	void insert(int sampleIdx, const AbcSample& sample);
+	void clear();
+
+	AbcCacheStats getStats();
+	void resetStats();
+
+private:
+	typedef std::list<std::pair<int, AbcSample>> EntryList;
+
+	void addBuffers(const AbcSample& sample, int delta);
+	void evict();
+
+	boost::mutex m_mutex;
+	size_t m_budget;
+	size_t m_bytes;
+	size_t m_hits;
+	size_t m_misses;
+	size_t m_evictions;
+
+	//front = most recently used
+	EntryList m_entries;
+	std::unordered_map<int, EntryList::iterator> m_index;
+	//how many cached samples reference each buffer, and its size
+	std::unordered_map<const void*, std::pair<size_t, size_t>> m_buffers;
+};
@@ -0,0 +1,107 @@
+#include "AbcSceneReader.h"
+
+#include <iostream>
+#include <algorithm>
+
+#include <Alembic/AbcGeom/All.h>
+#include <Alembic/AbcCoreHDF5/All.h>
+#include <Alembic/AbcCoreOgawa/All.h>
+#include <Alembic/AbcCoreFactory/All.h>
+
+AbcSceneReader::AbcSceneReader() : m_numSamples(0), m_currentSample(-1)
+{
+}
+
+AbcSceneReader::~AbcSceneReader()
+{
+}
+
+AbcThreadPool& AbcSceneReader::pool()
+{
+	return m_pool ? *m_pool : AbcThreadPool::defaultPool();
+}
+
+void AbcSceneReader::setNumThreads(size_t numThreads)
+{
+	m_pool = std::make_shared<AbcThreadPool>(numThreads);
+}
+
+void AbcSceneReader::setReadMode(READ_MODE mode)
+{
+	for(auto& mesh : m_meshes)
+	{
+		mesh->setReadMode(mode);
+	}
+}
+
+bool
+AbcSceneReader::openArchive(const std::string& file, const std::vector<std::string>& xFormNames, const std::vector<std::string>& meshNames,
+	const std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>>& arbGeoProperties)
+{
+	if(xFormNames.size() != meshNames.size() || arbGeoProperties.size() != meshNames.size())
+	{
+		std::cout << "ERROR: Need one transform name and one property list per mesh. (" << file << ")" << std::endl;
+		return false;
+	}
+
+	Alembic::AbcCoreFactory::IFactory factory;
+	factory.setPolicy(Alembic::Abc::ErrorHandler::kQuietNoopPolicy);
+	Alembic::AbcCoreFactory::IFactory::CoreType coreType;
+	//one Ogawa stream per worker so objects really are read concurrently
+	factory.setOgawaNumStreams(pool().getNumThreads());
+
+	//Open archive once for all objects
+	m_archive = std::make_shared<Alembic::Abc::IArchive>(factory.getArchive(file, coreType));
+	if(!m_archive->valid())
+	{
+		std::cout << "ERROR: Alembic Archive [" << file << "] could not be opened!" << std::endl;
+		return false;
+	}
+
+	m_meshes.clear();
+	m_numSamples = 0;
+	for(size_t i = 0; i < meshNames.size(); ++i)
+	{
+		m_meshes.emplace_back(std::make_shared<AbcReader>());
+		if(!m_meshes.back()->bindMesh(m_archive, xFormNames[i], meshNames[i], arbGeoProperties[i]))
+		{
+			m_meshes.clear();
+			return false;
+		}
+		m_numSamples = std::max(m_numSamples, m_meshes.back()->getNumSamples());
+	}
+
+	//make sure to read the first sample into memory
+	m_currentSample = -1;
+	return sampleSpecific(0);
+}
+
+bool
+AbcSceneReader::sampleForward()
+{
+	return sampleSpecific(m_currentSample + 1);
+}
+
+bool
+AbcSceneReader::sampleBackward()
+{
+	return sampleSpecific(m_currentSample - 1);
+}
+
+bool
+AbcSceneReader::sampleSpecific(int sample)
+{
+	if (sample < 0 || sample >= m_numSamples)
+	{
+		return false;
+	}
+
+	m_currentSample = sample;
+	pool().parallelFor(m_meshes.size(), [&](size_t i)
+	{
+		AbcReader& mesh = *m_meshes[i];
+		mesh.sampleSpecific(std::min(sample, mesh.getNumSamples() - 1));
+	});
+
+	return true;
+}
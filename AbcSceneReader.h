@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <memory>
+
+#include <Alembic/Abc/All.h>
+
+#include "easyAbcUtil.h"
+#include "AbcReader.h"
+#include "AbcThreadPool.h"
+
+//! Reads many xform/mesh pairs from one archive, the reading counterpart of AbcWriter's multi-mesh constructor.
+//! The archive is opened once and every object of a sample is decoded in parallel.
+class AbcSceneReader
+{
+public:
+	AbcSceneReader();
+	~AbcSceneReader();
+
+	bool openArchive(const std::string& file, const std::vector<std::string>& xFormNames, const std::vector<std::string>& meshNames,
+		const std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>>& arbGeoProperties);
+
+	//! Decode with a dedicated pool of numThreads instead of the shared default pool.
+	//! Call before openArchive, the archive is opened with one Ogawa stream per thread.
+	void setNumThreads(size_t numThreads);
+	//! Applied to every object, see AbcReader::setReadMode
+	void setReadMode(READ_MODE mode);
+
+	//Objects with fewer samples than the scene stay on their last sample
+	bool sampleForward();
+	bool sampleBackward();
+	bool sampleSpecific(int sample);
+
+	int getNumSamples() const { return m_numSamples; }
+	int getCurrentSample() const { return m_currentSample; }
+	size_t getNumObjects() const { return m_meshes.size(); }
+
+	//Per-object Data Accessors
+	AbcReader& getMesh(size_t meshIdx) { return *m_meshes[meshIdx]; }
+	const AbcSample& getSample(size_t meshIdx) const { return m_meshes[meshIdx]->getSample(); }
+
+private:
+	AbcThreadPool& pool();
+
+	std::shared_ptr<Alembic::Abc::IArchive> m_archive;
+	std::vector<std::shared_ptr<AbcReader>> m_meshes;
+	std::shared_ptr<AbcThreadPool> m_pool;
+
+	int m_numSamples;
+	int m_currentSample;
+};
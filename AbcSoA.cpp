@@ -0,0 +1,118 @@
+#include "AbcSoA.h"
+
+#include <new>
+
+#include <boost/align/aligned_alloc.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define EASYABC_SSE 1
+#endif
+
+AbcSoAVector3 allocateSoA(size_t count)
+{
+	AbcSoAVector3 soa;
+	if(count == 0)
+	{
+		return soa;
+	}
+
+	//each component starts on its own cache line
+	const size_t floatsPerLine = ABC_SOA_ALIGNMENT / sizeof(float);
+	const size_t stride = (count + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+	float* block = (float*)boost::alignment::aligned_alloc(ABC_SOA_ALIGNMENT, stride * 3 * sizeof(float));
+	if(!block)
+	{
+		throw std::bad_alloc();
+	}
+
+	std::shared_ptr<const void> owner(block, [](float* p) { boost::alignment::aligned_free(p); });
+	soa.x = AbcArrayView<float>(block, count, owner);
+	soa.y = AbcArrayView<float>(block + stride, count, owner);
+	soa.z = AbcArrayView<float>(block + stride * 2, count, owner);
+	return soa;
+}
+
+void deinterleaveV3f(const Alembic::Abc::V3f* in, size_t count, float* x, float* y, float* z)
+{
+	const float* src = (const float*)in;
+	size_t i = 0;
+
+#ifdef EASYABC_SSE
+	//a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+	for(; i + 4 <= count; i += 4, src += 12)
+	{
+		__m128 a = _mm_loadu_ps(src);
+		__m128 b = _mm_loadu_ps(src + 4);
+		__m128 c = _mm_loadu_ps(src + 8);
+
+		__m128 x2y2x3y3 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+		__m128 y0y0y1y1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		__m128 z0z0z1z1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		__m128 z2z2z3z3 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+
+		_mm_store_ps(x + i, _mm_shuffle_ps(a, x2y2x3y3, _MM_SHUFFLE(2, 0, 3, 0)));
+		_mm_store_ps(y + i, _mm_shuffle_ps(y0y0y1y1, x2y2x3y3, _MM_SHUFFLE(3, 1, 2, 0)));
+		_mm_store_ps(z + i, _mm_shuffle_ps(z0z0z1z1, z2z2z3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+#endif
+
+	for(; i < count; ++i, src += 3)
+	{
+		x[i] = src[0];
+		y[i] = src[1];
+		z[i] = src[2];
+	}
+}
+
+void interleaveV3f(const float* x, const float* y, const float* z, size_t count, Alembic::Abc::V3f* out)
+{
+	float* dst = (float*)out;
+	size_t i = 0;
+
+#ifdef EASYABC_SSE
+	for(; i + 4 <= count; i += 4, dst += 12)
+	{
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+
+		__m128 x0x0y0y0 = _mm_shuffle_ps(vx, vy, _MM_SHUFFLE(0, 0, 0, 0));
+		__m128 z0z0x1x1 = _mm_shuffle_ps(vz, vx, _MM_SHUFFLE(1, 1, 0, 0));
+		__m128 y1y1z1z1 = _mm_shuffle_ps(vy, vz, _MM_SHUFFLE(1, 1, 1, 1));
+		__m128 x2x2y2y2 = _mm_shuffle_ps(vx, vy, _MM_SHUFFLE(2, 2, 2, 2));
+		__m128 z2z2x3x3 = _mm_shuffle_ps(vz, vx, _MM_SHUFFLE(3, 3, 2, 2));
+		__m128 y3y3z3z3 = _mm_shuffle_ps(vy, vz, _MM_SHUFFLE(3, 3, 3, 3));
+
+		_mm_storeu_ps(dst, _mm_shuffle_ps(x0x0y0y0, z0z0x1x1, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(dst + 4, _mm_shuffle_ps(y1y1z1z1, x2x2y2y2, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(dst + 8, _mm_shuffle_ps(z2z2x3x3, y3y3z3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+#endif
+
+	for(; i < count; ++i, dst += 3)
+	{
+		dst[0] = x[i];
+		dst[1] = y[i];
+		dst[2] = z[i];
+	}
+}
+
+AbcSoAVector3 toSoA(const AbcArrayView<Alembic::Abc::V3f>& in)
+{
+	AbcSoAVector3 soa = allocateSoA(in.size());
+	if(!soa.empty())
+	{
+		deinterleaveV3f(in.data(), in.size(), (float*)soa.x.data(), (float*)soa.y.data(), (float*)soa.z.data());
+	}
+	return soa;
+}
+
+void fromSoA(const AbcSoAVector3& in, std::vector<Alembic::Abc::V3f>& out)
+{
+	out.resize(in.size());
+	if(!in.empty())
+	{
+		interleaveV3f(in.x.data(), in.y.data(), in.z.data(), in.size(), out.data());
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include <Alembic/Abc/All.h>
+
+#include "AbcSample.h"
+
+//! Alignment of every SoA component buffer, one cache line
+static const size_t ABC_SOA_ALIGNMENT = 64;
+
+//! Uninitialised x, y, z buffers for count elements in a single aligned allocation owned by the views
+AbcSoAVector3 allocateSoA(size_t count);
+
+//! Transposes count interleaved vectors into x, y, z (SSE when available, 4 vectors per step).
+//! x, y and z have to be 16 byte aligned.
+void deinterleaveV3f(const Alembic::Abc::V3f* in, size_t count, float* x, float* y, float* z);
+//! Inverse of deinterleaveV3f, any alignment
+void interleaveV3f(const float* x, const float* y, const float* z, size_t count, Alembic::Abc::V3f* out);
+
+//! Aligned SoA copy of an interleaved array
+AbcSoAVector3 toSoA(const AbcArrayView<Alembic::Abc::V3f>& in);
+//! Interleaves into out, reusing its capacity
+void fromSoA(const AbcSoAVector3& in, std::vector<Alembic::Abc::V3f>& out);
@@ -0,0 +1,178 @@
+#include "AbcStats.h"
+
+#include <iostream>
+#include <iomanip>
+
+const char* statsPhaseName(STATS_PHASE phase)
+{
+	switch(phase)
+	{
+	case READ_SAMPLE: return "read sample";
+	case READ_DECODE: return "read decode";
+	case READ_POSITIONS: return "read positions";
+	case READ_TOPOLOGY: return "read topology";
+	case READ_NORMALS: return "read normals";
+	case READ_PROPERTIES: return "read properties";
+	case READ_TRANSPOSE: return "read transpose";
+	case READ_COPY_OUT: return "read copy out";
+	case READ_INTERPOLATE: return "read interpolate";
+	case WRITE_SAMPLE: return "write sample";
+	case WRITE_SETUP: return "write setup";
+	case WRITE_PROPERTIES: return "write properties";
+	case WRITE_SCHEMA_SET: return "write schema set";
+	case WRITE_QUEUE_WAIT: return "write queue wait";
+	case WRITE_COMMIT_WAIT: return "write commit wait";
+	default: return "unknown";
+	}
+}
+
+static int bucketOf(uint64_t nanos)
+{
+	uint64_t micros = nanos / 1000;
+	int bucket = 0;
+	while(micros > 0 && bucket < ABC_STATS_BUCKETS - 1)
+	{
+		micros >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+static int64_t nowNanos()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double AbcPhaseStats::percentileMicros(double p) const
+{
+	if(count == 0)
+	{
+		return 0.0;
+	}
+
+	uint64_t rank = (uint64_t)(p * count);
+	uint64_t seen = 0;
+	for(int i = 0; i < ABC_STATS_BUCKETS; ++i)
+	{
+		seen += histogram[i];
+		if(seen > rank || i == ABC_STATS_BUCKETS - 1)
+		{
+			//the top bucket is open ended, its largest value is the maximum
+			return i == ABC_STATS_BUCKETS - 1 ? maxNanos / 1000.0 : (double)(1ull << i);
+		}
+	}
+	return maxNanos / 1000.0;
+}
+
+void AbcStatsSnapshot::print(std::ostream& out) const
+{
+	std::ios::fmtflags flags = out.flags();
+	out << std::fixed << std::setprecision(1);
+	for(int i = 0; i < NUM_STATS_PHASES; ++i)
+	{
+		const AbcPhaseStats& phase = phases[i];
+		if(phase.count == 0)
+		{
+			continue;
+		}
+		out << "  " << std::left << std::setw(18) << statsPhaseName((STATS_PHASE)i) << std::right
+			<< " n=" << phase.count
+			<< " total=" << phase.totalNanos / 1.0e6 << "ms"
+			<< " mean=" << phase.meanMicros() << "us"
+			<< " p50<=" << phase.percentileMicros(0.5) << "us"
+			<< " p99<=" << phase.percentileMicros(0.99) << "us"
+			<< " max=" << phase.maxNanos / 1000.0 << "us" << std::endl;
+	}
+	out << "  read " << bytesRead / (1024.0 * 1024.0) << "MB, written " << bytesWritten / (1024.0 * 1024.0)
+		<< "MB, " << allocations << " allocations" << std::endl;
+	out.flags(flags);
+}
+
+AbcStats::AbcStats(const std::string& label) : m_label(label), m_enabled(true), m_dumpIntervalNanos(0), m_lastDump(0)
+{
+	reset();
+}
+
+void AbcStats::setDumpInterval(double seconds)
+{
+	m_dumpIntervalNanos.store((int64_t)(seconds * 1.0e9), std::memory_order_relaxed);
+	m_lastDump.store(nowNanos(), std::memory_order_relaxed);
+}
+
+void AbcStats::record(STATS_PHASE phase, uint64_t nanos)
+{
+	if(!isEnabled())
+	{
+		return;
+	}
+
+	Phase& p = m_phases[phase];
+	p.count.fetch_add(1, std::memory_order_relaxed);
+	p.totalNanos.fetch_add(nanos, std::memory_order_relaxed);
+	p.histogram[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t max = p.maxNanos.load(std::memory_order_relaxed);
+	while(nanos > max && !p.maxNanos.compare_exchange_weak(max, nanos, std::memory_order_relaxed))
+	{
+	}
+
+	maybeDump();
+}
+
+void AbcStats::maybeDump()
+{
+	int64_t interval = m_dumpIntervalNanos.load(std::memory_order_relaxed);
+	if(interval <= 0)
+	{
+		return;
+	}
+
+	//only the thread that moves m_lastDump forward prints
+	int64_t now = nowNanos();
+	int64_t last = m_lastDump.load(std::memory_order_relaxed);
+	if(now - last < interval || !m_lastDump.compare_exchange_strong(last, now, std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	std::cout << "Stats [" << m_label << "]" << std::endl;
+	snapshot().print(std::cout);
+}
+
+AbcStatsSnapshot AbcStats::snapshot() const
+{
+	AbcStatsSnapshot s;
+	for(int i = 0; i < NUM_STATS_PHASES; ++i)
+	{
+		const Phase& p = m_phases[i];
+		s.phases[i].count = p.count.load(std::memory_order_relaxed);
+		s.phases[i].totalNanos = p.totalNanos.load(std::memory_order_relaxed);
+		s.phases[i].maxNanos = p.maxNanos.load(std::memory_order_relaxed);
+		for(int b = 0; b < ABC_STATS_BUCKETS; ++b)
+		{
+			s.phases[i].histogram[b] = p.histogram[b].load(std::memory_order_relaxed);
+		}
+	}
+	s.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+	s.bytesWritten = m_bytesWritten.load(std::memory_order_relaxed);
+	s.allocations = m_allocations.load(std::memory_order_relaxed);
+	return s;
+}
+
+void AbcStats::reset()
+{
+	for(int i = 0; i < NUM_STATS_PHASES; ++i)
+	{
+		Phase& p = m_phases[i];
+		p.count.store(0, std::memory_order_relaxed);
+		p.totalNanos.store(0, std::memory_order_relaxed);
+		p.maxNanos.store(0, std::memory_order_relaxed);
+		for(int b = 0; b < ABC_STATS_BUCKETS; ++b)
+		{
+			p.histogram[b].store(0, std::memory_order_relaxed);
+		}
+	}
+	m_bytesRead.store(0, std::memory_order_relaxed);
+	m_bytesWritten.store(0, std::memory_order_relaxed);
+	m_allocations.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+enum STATS_PHASE
+{
+    READ_SAMPLE,        //whole sampleForward/sampleBackward/sampleSpecific/sampleAtTime step
+    READ_DECODE,        //one sample decoded from the archive (cache misses only)
+    READ_POSITIONS,
+    READ_TOPOLOGY,
+    READ_NORMALS,
+    READ_PROPERTIES,    //arbGeomParam lookup and expansion
+    READ_TRANSPOSE,     //READ_SOA mode de-interleaving
+    READ_COPY_OUT,      //READ_COPY mode copies
+    READ_INTERPOLATE,   //sampleAtTime sub-frame positions
+    WRITE_SAMPLE,       //whole sample written to the archive
+    WRITE_SETUP,        //building the alembic sample
+    WRITE_PROPERTIES,   //arbGeomParam sets
+    WRITE_SCHEMA_SET,
+    WRITE_QUEUE_WAIT,   //asynchronous mode, time blocked on a full queue
+    WRITE_COMMIT_WAIT,  //time waiting for another sample to finish writing to the archive
+    NUM_STATS_PHASES,
+};
+
+const char* statsPhaseName(STATS_PHASE phase);
+
+//! Latency histogram buckets: bucket 0 is < 1us, bucket i covers [2^(i-1), 2^i) us, the last one everything above
+static const int ABC_STATS_BUCKETS = 24;
+
+struct AbcPhaseStats
+{
+	uint64_t count;
+	uint64_t totalNanos;
+	uint64_t maxNanos;
+	uint64_t histogram[ABC_STATS_BUCKETS];
+
+	double meanMicros() const { return count ? totalNanos / 1000.0 / count : 0.0; }
+	//! Upper bound of the histogram bucket holding the p-th percentile (0..1)
+	double percentileMicros(double p) const;
+};
+
+//! Point-in-time copy of the counters of an AbcStats
+struct AbcStatsSnapshot
+{
+	AbcPhaseStats phases[NUM_STATS_PHASES];
+	uint64_t bytesRead;
+	uint64_t bytesWritten;
+	//! buffers allocated on the hot path: decoded alembic arrays, READ_COPY growth and asynchronous copies
+	uint64_t allocations;
+
+	//! One line per phase that ran, plus the byte and allocation counters
+	void print(std::ostream& out) const;
+};
+
+//! Lock-free per-phase timers and counters, shared by every thread decoding or writing for one reader/writer.
+class AbcStats
+{
+public:
+	explicit AbcStats(const std::string& label = "");
+
+	//! Disabled stats skip the clock entirely. Enabled by default.
+	void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+	bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+	//! Print a snapshot to std::cout at most every seconds, from whichever thread records next (0 = off)
+	void setDumpInterval(double seconds);
+	void setLabel(const std::string& label) { m_label = label; }
+
+	void record(STATS_PHASE phase, uint64_t nanos);
+	void addBytesRead(uint64_t bytes) { if(isEnabled()) m_bytesRead.fetch_add(bytes, std::memory_order_relaxed); }
+	void addBytesWritten(uint64_t bytes) { if(isEnabled()) m_bytesWritten.fetch_add(bytes, std::memory_order_relaxed); }
+	void addAllocations(uint64_t count) { if(isEnabled()) m_allocations.fetch_add(count, std::memory_order_relaxed); }
+
+	AbcStatsSnapshot snapshot() const;
+	void reset();
+
+private:
+	struct Phase
+	{
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> totalNanos;
+		std::atomic<uint64_t> maxNanos;
+		std::atomic<uint64_t> histogram[ABC_STATS_BUCKETS];
+	};
+
+	void maybeDump();
+
+	std::string m_label;
+	std::atomic<bool> m_enabled;
+	Phase m_phases[NUM_STATS_PHASES];
+	std::atomic<uint64_t> m_bytesRead;
+	std::atomic<uint64_t> m_bytesWritten;
+	std::atomic<uint64_t> m_allocations;
+
+	std::atomic<int64_t> m_dumpIntervalNanos;
+	std::atomic<int64_t> m_lastDump;
+};
+
+//! Records the time until it goes out of scope (or stop()) as one sample of phase
+class AbcStatsTimer
+{
+public:
+	AbcStatsTimer(AbcStats& stats, STATS_PHASE phase) : m_stats(stats), m_phase(phase), m_running(stats.isEnabled())
+	{
+		if(m_running)
+		{
+			m_start = std::chrono::steady_clock::now();
+		}
+	}
+
+	~AbcStatsTimer() { stop(); }
+
+	void stop()
+	{
+		if(m_running)
+		{
+			m_running = false;
+			m_stats.record(m_phase, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+		}
+	}
+
+	AbcStatsTimer(const AbcStatsTimer&) = delete;
+	AbcStatsTimer& operator=(const AbcStatsTimer&) = delete;
+
+private:
+	AbcStats& m_stats;
+	STATS_PHASE m_phase;
+	bool m_running;
+	std::chrono::steady_clock::time_point m_start;
+};
@@ -0,0 +1,181 @@
+#include "AbcThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+AbcThreadPool::AbcThreadPool(size_t numThreads) : m_stop(false)
+{
+	if(numThreads == 0)
+	{
+		numThreads = std::max(1u, boost::thread::hardware_concurrency());
+	}
+
+	for(size_t i = 0; i < numThreads; ++i)
+	{
+		m_threads.emplace_back(&AbcThreadPool::run, this);
+	}
+}
+
+AbcThreadPool::~AbcThreadPool()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+
+	for(auto& t : m_threads)
+	{
+		t.join();
+	}
+}
+
+AbcThreadPool& AbcThreadPool::defaultPool()
+{
+	static AbcThreadPool pool;
+	return pool;
+}
+
+void AbcThreadPool::submit(const std::function<void()>& task)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		m_tasks.push_back(task);
+	}
+	m_condition.notify_one();
+}
+
+void AbcThreadPool::helpUntil(const std::function<bool()>& done)
+{
+	//every finished task notifies m_condition, so a task that makes done() true wakes us
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	while(!done())
+	{
+		if(!runPendingTask(lock))
+		{
+			m_condition.wait(lock);
+		}
+	}
+}
+
+void AbcThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+	if(count == 0)
+	{
+		return;
+	}
+	if(count == 1)
+	{
+		func(0);
+		return;
+	}
+
+	//shared between the tasks of this batch, guarded by m_mutex
+	size_t remaining = count;
+	std::exception_ptr error;
+
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		for(size_t i = 0; i < count; ++i)
+		{
+			m_tasks.push_back([&, i]()
+			{
+				std::exception_ptr taskError;
+				try
+				{
+					func(i);
+				}
+				catch(...)
+				{
+					taskError = std::current_exception();
+				}
+
+				boost::unique_lock<boost::mutex> taskLock(m_mutex);
+				if(taskError && !error)
+				{
+					error = taskError;
+				}
+				--remaining;
+			});
+		}
+	}
+	m_condition.notify_all();
+
+	//help instead of blocking a core, this also keeps nested calls from deadlocking
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	while(remaining > 0)
+	{
+		if(!runPendingTask(lock))
+		{
+			m_condition.wait(lock);
+		}
+	}
+
+	if(error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+void AbcThreadPool::parallelForChunks(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func)
+{
+	if(count <= chunkSize)
+	{
+		if(count > 0)
+		{
+			func(0, count);
+		}
+		return;
+	}
+
+	parallelFor((count + chunkSize - 1) / chunkSize, [&](size_t chunk)
+	{
+		func(chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+	});
+}
+
+bool AbcThreadPool::runPendingTask(boost::unique_lock<boost::mutex>& lock)
+{
+	if(m_tasks.empty())
+	{
+		return false;
+	}
+
+	std::function<void()> task = std::move(m_tasks.front());
+	m_tasks.pop_front();
+
+	lock.unlock();
+	try
+	{
+		task();
+	}
+	catch(std::exception& e)
+	{
+		std::cout << "ERROR: Uncaught exception in thread pool task: " << e.what() << std::endl;
+	}
+	lock.lock();
+
+	//someone may be waiting for this task to finish
+	m_condition.notify_all();
+	return true;
+}
+
+void AbcThreadPool::run()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	while(true)
+	{
+		if(runPendingTask(lock))
+		{
+			continue;
+		}
+
+		if(m_stop)
+		{
+			break;
+		}
+
+		m_condition.wait(lock);
+	}
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <map>
+#include <functional>
+#include <exception>
+
+#include <boost/thread.hpp>
+
+//! Fixed set of worker threads used to decode/encode several samples or objects at once
+class AbcThreadPool
+{
+public:
+	//! numThreads = 0 uses one thread per hardware core
+	explicit AbcThreadPool(size_t numThreads = 0);
+	~AbcThreadPool();
+
+	size_t getNumThreads() const { return m_threads.size(); }
+
+	//! Run func(i) for every i in [0, count) and wait until all calls are done.
+	//! The calling thread helps out, so this may be nested inside another parallelFor.
+	//! The first exception thrown by func is rethrown here.
+	void parallelFor(size_t count, const std::function<void(size_t)>& func);
+
+	//! parallelFor over [begin, end) ranges of at most chunkSize items, for loops over single elements
+	void parallelForChunks(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& func);
+
+	//! Queue a task without waiting for it
+	void submit(const std::function<void()>& task);
+
+	//! Run queued tasks on the calling thread until done() returns true, for callers waiting on tasks they submitted.
+	//! done is checked with the pool locked, after every task that finishes anywhere, and must not submit.
+	void helpUntil(const std::function<bool()>& done);
+
+	//! Run produce(i, item) for every i in [0, count) on the pool, at most window (0 = two per worker) ahead of the
+	//! next item consume takes, and hand the items to consume(i, item) on the calling thread one at a time, in order
+	//! or as they finish. consume returning false stops early. The first exception of either is rethrown once
+	//! every produce call has returned.
+	template <typename T>
+	void orderedPrefetch(size_t count, size_t window, const std::function<void(size_t, T&)>& produce,
+		const std::function<bool(size_t, T&)>& consume, bool inOrder = true);
+
+	//! Pool shared by everything that does not ask for its own
+	static AbcThreadPool& defaultPool();
+
+private:
+	void run();
+	bool runPendingTask(boost::unique_lock<boost::mutex>& lock);
+
+	boost::mutex m_mutex;
+	boost::condition_variable m_condition;
+	std::deque<std::function<void()>> m_tasks;
+	std::vector<boost::thread> m_threads;
+	bool m_stop;
+};
+
+template <typename T>
+void AbcThreadPool::orderedPrefetch(size_t count, size_t window, const std::function<void(size_t, T&)>& produce,
+	const std::function<bool(size_t, T&)>& consume, bool inOrder)
+{
+	//enough items in flight to keep every worker busy, but not all of them in memory
+	if(window == 0)
+	{
+		window = getNumThreads() * 2;
+	}
+
+	boost::mutex mutex;
+	std::map<size_t, T> produced;
+	std::exception_ptr error;
+	size_t inFlight = 0;
+	size_t nextToSubmit = 0;
+	size_t numConsumed = 0;
+	bool stopped = false;
+
+	boost::unique_lock<boost::mutex> lock(mutex);
+	while(numConsumed < count && !error && !stopped)
+	{
+		while(nextToSubmit < count && nextToSubmit - numConsumed < window)
+		{
+			size_t idx = nextToSubmit++;
+			++inFlight;
+			submit([&, idx]()
+			{
+				T item;
+				std::exception_ptr itemError;
+				try
+				{
+					produce(idx, item);
+				}
+				catch(...)
+				{
+					itemError = std::current_exception();
+				}
+
+				boost::unique_lock<boost::mutex> taskLock(mutex);
+				if(itemError)
+				{
+					error = itemError;
+				}
+				else
+				{
+					produced[idx] = std::move(item);
+				}
+				--inFlight;
+			});
+		}
+
+		//wait for the next item in order, or any item
+		auto ready = inOrder ? produced.find(numConsumed) : produced.begin();
+		if(ready == produced.end())
+		{
+			//run queued tasks while waiting, the caller may be one of the pool's own workers
+			lock.unlock();
+			helpUntil([&]()
+			{
+				boost::unique_lock<boost::mutex> checkLock(mutex);
+				return error || (inOrder ? produced.count(numConsumed) > 0 : !produced.empty());
+			});
+			lock.lock();
+			continue;
+		}
+
+		const size_t idx = ready->first;
+		std::exception_ptr consumeError;
+		{
+			T item = std::move(ready->second);
+			produced.erase(ready);
+			++numConsumed;
+
+			//the items are consumed on the calling thread while the workers produce ahead
+			lock.unlock();
+			try
+			{
+				stopped = !consume(idx, item);
+			}
+			catch(...)
+			{
+				consumeError = std::current_exception();
+			}
+		}
+		lock.lock();
+		if(consumeError)
+		{
+			error = consumeError;
+		}
+	}
+
+	//the workers reference this stack frame
+	lock.unlock();
+	helpUntil([&]()
+	{
+		boost::unique_lock<boost::mutex> checkLock(mutex);
+		return inFlight == 0;
+	});
+
+	if(error)
+	{
+		std::rethrow_exception(error);
+	}
+}
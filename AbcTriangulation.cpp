@@ -0,0 +1,124 @@
+#include "AbcTriangulation.h"
+
+#include <algorithm>
+
+static const size_t TRIANGULATION_CHUNK_SIZE = 1 << 14;
+
+static bool sameTopology(const std::shared_ptr<const AbcTriangulation>& triangulation, const AbcArrayView<int>& faceIndices,
+	const AbcArrayView<int>& faceCounts, size_t numPoints)
+{
+	return triangulation && triangulation->numPoints == numPoints && sameContents(triangulation->faceCounts, faceCounts)
+		&& sameContents(triangulation->faceIndices, faceIndices);
+}
+
+void AbcTriangulator::rememberFailure(const std::shared_ptr<AbcTriangulation>& triangulation)
+{
+	triangulation->indices = std::vector<int>();
+	triangulation->corners = std::vector<int>();
+	triangulation->triangleFaces = std::vector<int>();
+
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_failed = triangulation;
+}
+
+std::shared_ptr<const AbcTriangulation> AbcTriangulator::triangulate(const AbcArrayView<int>& faceIndices, const AbcArrayView<int>& faceCounts,
+	size_t numPoints)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		if(sameTopology(m_triangulation, faceIndices, faceCounts, numPoints))
+		{
+			return m_triangulation;
+		}
+		//already reported
+		if(sameTopology(m_failed, faceIndices, faceCounts, numPoints))
+		{
+			return nullptr;
+		}
+	}
+
+	AbcThreadPool& pool = AbcThreadPool::defaultPool();
+	const size_t numFaces = faceCounts.size();
+	const size_t numChunks = (numFaces + TRIANGULATION_CHUNK_SIZE - 1) / TRIANGULATION_CHUNK_SIZE;
+
+	//prefix sums in two passes: per chunk totals in parallel, then chunk offsets, then per face offsets in parallel
+	std::vector<size_t> chunkCorners(numChunks + 1, 0);
+	std::vector<size_t> chunkTriangles(numChunks + 1, 0);
+	pool.parallelFor(numChunks, [&](size_t chunk)
+	{
+		size_t end = std::min(numFaces, (chunk + 1) * TRIANGULATION_CHUNK_SIZE);
+		for(size_t f = chunk * TRIANGULATION_CHUNK_SIZE; f < end; ++f)
+		{
+			int count = std::max(faceCounts[f], 0);
+			chunkCorners[chunk + 1] += count;
+			chunkTriangles[chunk + 1] += count >= 3 ? count - 2 : 0;
+		}
+	});
+	for(size_t chunk = 0; chunk < numChunks; ++chunk)
+	{
+		chunkCorners[chunk + 1] += chunkCorners[chunk];
+		chunkTriangles[chunk + 1] += chunkTriangles[chunk];
+	}
+
+	std::shared_ptr<AbcTriangulation> triangulation = std::make_shared<AbcTriangulation>();
+	//the caller's buffers may be refilled, keep our own copy unless they are shared
+	triangulation->faceIndices = faceIndices.owner() ? faceIndices : AbcArrayView<int>::adopt(faceIndices.toVector());
+	triangulation->faceCounts = faceCounts.owner() ? faceCounts : AbcArrayView<int>::adopt(faceCounts.toVector());
+	triangulation->numPoints = numPoints;
+
+	if(chunkCorners.back() != faceIndices.size())
+	{
+		std::cout << "ERROR: Face counts do not add up to the face indices, the mesh cannot be triangulated." << std::endl;
+		rememberFailure(triangulation);
+		return nullptr;
+	}
+
+	triangulation->indices.resize(chunkTriangles.back() * 3);
+	triangulation->corners.resize(chunkTriangles.back() * 3);
+	triangulation->triangleFaces.resize(chunkTriangles.back());
+
+	//fan around the first corner of every polygon, checking the points it references on the way
+	std::vector<char> chunkValid(numChunks, 1);
+	pool.parallelFor(numChunks, [&](size_t chunk)
+	{
+		bool valid = true;
+		size_t corner = chunkCorners[chunk];
+		size_t triangle = chunkTriangles[chunk];
+		size_t end = std::min(numFaces, (chunk + 1) * TRIANGULATION_CHUNK_SIZE);
+		for(size_t f = chunk * TRIANGULATION_CHUNK_SIZE; f < end; ++f)
+		{
+			int count = std::max(faceCounts[f], 0);
+			for(int i = 1; i + 1 < count; ++i, ++triangle)
+			{
+				int* corners = &triangulation->corners[triangle * 3];
+				corners[0] = (int)corner;
+				corners[1] = (int)corner + i;
+				corners[2] = (int)corner + i + 1;
+
+				int* indices = &triangulation->indices[triangle * 3];
+				indices[0] = faceIndices[corners[0]];
+				indices[1] = faceIndices[corners[1]];
+				indices[2] = faceIndices[corners[2]];
+				for(int c = 0; c < 3; ++c)
+				{
+					valid = valid && indices[c] >= 0 && (size_t)indices[c] < numPoints;
+				}
+
+				triangulation->triangleFaces[triangle] = (int)f;
+			}
+			corner += count;
+		}
+		chunkValid[chunk] = valid;
+	});
+
+	if(std::find(chunkValid.begin(), chunkValid.end(), 0) != chunkValid.end())
+	{
+		std::cout << "ERROR: Face indices reference points past the mesh's " << numPoints << " points, it cannot be triangulated." << std::endl;
+		rememberFailure(triangulation);
+		return nullptr;
+	}
+
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	m_triangulation = triangulation;
+	return triangulation;
+}
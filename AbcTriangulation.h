@@ -0,0 +1,72 @@
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "easyAbcUtil.h"
+#include "AbcSample.h"
+#include "AbcThreadPool.h"
+
+//! Render-ready triangle list of a polygon mesh, 3 entries per triangle in every array
+struct AbcTriangulation
+{
+	//the topology this was built from
+	AbcArrayView<int> faceIndices;
+	AbcArrayView<int> faceCounts;
+	//every point index is below it
+	size_t numPoints;
+
+	size_t numTriangles() const { return triangleFaces.size(); }
+
+	//point index of every triangle corner
+	std::vector<int> indices;
+	//face corner (index into faceIndices) of every triangle corner, for facevarying attributes
+	std::vector<int> corners;
+	//source polygon of every triangle
+	std::vector<int> triangleFaces;
+};
+
+//! Fan triangulates polygon soups in parallel and keeps the result until the topology changes.
+//! Fans keep alembic's winding and only depend on the topology, so deforming meshes triangulate once.
+class AbcTriangulator
+{
+public:
+	//! nullptr if faceCounts does not add up to faceIndices or a triangle references a point past numPoints.
+	//! Failures are remembered as well, the same broken topology is only checked (and reported) once.
+	std::shared_ptr<const AbcTriangulation> triangulate(const AbcArrayView<int>& faceIndices, const AbcArrayView<int>& faceCounts,
+		size_t numPoints);
+
+private:
+	void rememberFailure(const std::shared_ptr<AbcTriangulation>& triangulation);
+
+	boost::mutex m_mutex;
+	std::shared_ptr<const AbcTriangulation> m_triangulation;
+	//topology of the last failed attempt, without triangles
+	std::shared_ptr<const AbcTriangulation> m_failed;
+};
+
+//! Gathers an attribute onto the triangle corners: POINT/VERTEX values are per point, FACE (facevarying) per face corner.
+//! Empty if values does not have the size the scope asks for.
+template <typename T>
+AbcArrayView<T> expandToTriangles(const AbcArrayView<T>& values, PROP_SCOPE scope, const AbcTriangulation& triangulation, size_t numPoints)
+{
+	const std::vector<int>& lookup = scope == FACE ? triangulation.corners : triangulation.indices;
+	if(values.size() != (scope == FACE ? triangulation.faceIndices.size() : numPoints))
+	{
+		std::cout << "ERROR: Attribute size " << values.size() << " does not match its scope, it cannot be expanded onto triangles." << std::endl;
+		return AbcArrayView<T>();
+	}
+
+	std::vector<T> expanded(lookup.size());
+	AbcThreadPool::defaultPool().parallelForChunks(lookup.size(), 1 << 15, [&](size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
+		{
+			expanded[i] = values[lookup[i]];
+		}
+	});
+	return AbcArrayView<T>::adopt(std::move(expanded));
+}
@@ -0,0 +1,101 @@
+#include "AbcWriteQueue.h"
+
+#include <algorithm>
+#include <exception>
+
+AbcWriteQueue::AbcWriteQueue(size_t maxQueuedJobs, size_t maxQueuedBytes) : m_maxQueuedJobs(std::max<size_t>(1, maxQueuedJobs)),
+	m_maxQueuedBytes(maxQueuedBytes), m_stop(false), m_busy(false), m_queuedBytes(0)
+{
+	m_thread = boost::thread(&AbcWriteQueue::run, this);
+}
+
+AbcWriteQueue::~AbcWriteQueue()
+{
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+}
+
+void AbcWriteQueue::push(const Job& job, size_t bytes)
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+
+	//back-pressure: wait for the writer to catch up, but always admit a job into an empty queue
+	while(!m_jobs.empty() && (m_jobs.size() >= m_maxQueuedJobs
+		|| (m_maxQueuedBytes > 0 && m_queuedBytes + bytes > m_maxQueuedBytes)))
+	{
+		m_condition.wait(lock);
+	}
+
+	m_jobs.push_back(std::make_pair(job, bytes));
+	m_queuedBytes += bytes;
+	m_condition.notify_all();
+}
+
+bool AbcWriteQueue::flush()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	while(!m_jobs.empty() || m_busy)
+	{
+		m_condition.wait(lock);
+	}
+	return m_errors.empty();
+}
+
+std::vector<std::string> AbcWriteQueue::takeErrors()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	std::vector<std::string> errors;
+	errors.swap(m_errors);
+	return errors;
+}
+
+void AbcWriteQueue::run()
+{
+	boost::unique_lock<boost::mutex> lock(m_mutex);
+	while(true)
+	{
+		while(m_jobs.empty() && !m_stop)
+		{
+			m_condition.wait(lock);
+		}
+
+		//drain everything before stopping
+		if(m_jobs.empty())
+		{
+			break;
+		}
+
+		//keep the job queued (and its bytes counted) until it has run
+		Job job = m_jobs.front().first;
+		m_busy = true;
+
+		lock.unlock();
+		std::string error;
+		try
+		{
+			job();
+		}
+		catch(std::exception& e)
+		{
+			error = e.what();
+		}
+		catch(...)
+		{
+			error = "unknown error";
+		}
+		lock.lock();
+
+		m_queuedBytes -= m_jobs.front().second;
+		m_jobs.pop_front();
+		m_busy = false;
+		if(!error.empty())
+		{
+			m_errors.push_back(error);
+		}
+		m_condition.notify_all();
+	}
+}
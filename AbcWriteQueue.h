@@ -0,0 +1,45 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <boost/thread.hpp>
+
+//! Runs write jobs in submission order on a single background thread.
+//! push() blocks while the queue is full, so memory held by pending samples stays bounded.
+class AbcWriteQueue
+{
+public:
+	typedef std::function<void()> Job;
+
+	//! maxQueuedBytes = 0 only limits the number of queued jobs
+	AbcWriteQueue(size_t maxQueuedJobs, size_t maxQueuedBytes = 0);
+	//! Waits for all pending jobs
+	~AbcWriteQueue();
+
+	//! bytes is the memory the job holds on to until it has run
+	void push(const Job& job, size_t bytes);
+
+	//! Wait until every pushed job has run. Returns false if any of them threw since the last flush.
+	bool flush();
+	//! Messages of the jobs that threw since the last call
+	std::vector<std::string> takeErrors();
+
+private:
+	void run();
+
+	size_t m_maxQueuedJobs;
+	size_t m_maxQueuedBytes;
+
+	boost::mutex m_mutex;
+	boost::condition_variable m_condition;
+	boost::thread m_thread;
+	bool m_stop;
+	bool m_busy;
+
+	std::deque<std::pair<Job, size_t>> m_jobs;
+	size_t m_queuedBytes;
+	std::vector<std::string> m_errors;
+};
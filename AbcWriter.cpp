@@ -1,21 +1,161 @@
 #include "AbcWriter.h"
 
 #include <iostream>
+#include <map>
+#include <unordered_map>
 
 #include <Alembic/AbcGeom/All.h>
 #include <Alembic/AbcCoreHDF5/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
 #include <Alembic/AbcCoreFactory/All.h>
 
+#include "AbcSoA.h"
+#include "AbcBounds.h"
+#include "AbcNormals.h"
+#include "AbcQuantize.h"
+#include "AbcIndexing.h"
+
+//! Where a declared property ends up, resolved once in setupObject
+struct AbcWriterPropertySlot
+{
+	std::string name;
+	Alembic::AbcGeom::GeometryScope scope;
+	bool isColour;
+	PROP_ENCODING encoding;
+	//into the param list of the property's type, or of its encoding
+	size_t paramIdx;
+	//plain VECTOR params are created all together with the mesh's first sample (or on close without one),
+	//indexed if auto-indexing is on and that sample's values repeat enough
+	bool created;
+	bool indexed;
+};
+
+//! One property of an AbcPreparedSample
+struct AbcPreparedProperty
+{
+	AbcPreparedProperty() : haveIndices(false) {}
+
+	//FLOAT32 values as given (VECTOR ones interleaved if they came as SoA), encodings fill their own buffer instead
+	AbcArrayView<float> floats;
+	AbcArrayView<Alembic::Abc::V3f> vectors;
+	std::vector<Alembic::Abc::V3f> interleaved;
+	std::vector<Alembic::Util::float16_t> half;
+	std::vector<uint16_t> quantized;
+	Alembic::Abc::Box3f range;
+	std::vector<uint8_t> unorm8;
+
+	//unique values and an index per element, if the VECTOR values were hashed within the limit
+	bool haveIndices;
+	std::vector<Alembic::Abc::V3f> unique;
+	std::vector<uint32_t> indices;
+};
+
+//! A mesh sample with all the work but the archive writes done: SoA interleaved, bounds and normals computed,
+//! properties encoded and hashed. The views point at the caller's buffers or into the vectors held here.
+struct AbcPreparedSample
+{
+	AbcPreparedSample() : meshIdx(0), numBytes(0), hasNormals(false), normalsScope(Alembic::AbcGeom::kVaryingScope) {}
+
+	size_t meshIdx;
+	size_t numBytes;
+	AbcArrayView<Alembic::Abc::V3f> vertices;
+	std::vector<Alembic::Abc::V3f> interleavedVertices;
+	AbcArrayView<int> faceIndices;
+	AbcArrayView<int> faceCounts;
+	Alembic::Abc::Box3d bounds;
+	bool hasNormals;
+	Alembic::AbcGeom::GeometryScope normalsScope;
+	AbcArrayView<Alembic::Abc::V3f> normals;
+	std::vector<Alembic::Abc::V3f> interleavedNormals;
+	std::vector<AbcPreparedProperty> floatProps;
+	std::vector<AbcPreparedProperty> vectorProps;
+};
 
 struct AbcWriterImp
 {
 	std::shared_ptr<Alembic::AbcGeom::OPolyMesh> mesh;
 	std::shared_ptr<Alembic::AbcGeom::OXform> transform;
+
+	//in declaration order per type, matches AbcWriterSample::floatProps/vectorProps
+	std::vector<AbcWriterPropertySlot> floatSlots;
+	std::vector<AbcWriterPropertySlot> vectorSlots;
+	std::unordered_map<std::string, std::pair<PROP_TYPE, int>> propertySlots;
+
+	AbcNormalGenerator normalGenerator;
+
+	//created with the first sample when child bounds are written
+	Alembic::Abc::OBox3dProperty childBounds;
+
+	//encoded properties, FLOAT and VECTOR alike. The vectors are stored as 3 components per element
+	//(colours in UNORM8 as C3c). Every quantized param has its per-sample range at the same index.
+	std::vector<Alembic::AbcGeom::OHalfGeomParam> halfParams;
+	std::vector<Alembic::AbcGeom::OUInt16GeomParam> quantizedParams;
+	std::vector<Alembic::Abc::OBox3fProperty> quantizedRanges;
+	std::vector<Alembic::AbcGeom::OUcharGeomParam> unorm8Params;
+	std::vector<Alembic::AbcGeom::OC3cGeomParam> colour8Params;
+
+	AbcWriterImp() : haveTopology(false), nextFrame(0), committing(false) {}
+
+	//topology of the last committed sample (owned), a following sample with the same one only references it
+	bool haveTopology;
+	AbcArrayView<int> lastFaceIndices;
+	AbcArrayView<int> lastFaceCounts;
+
+	//buffers of synchronous and asynchronous writes, reused every sample
+	AbcPreparedSample scratch;
+
+	//addSample(sample, frame): samples that arrived ahead of nextFrame, committed once the gap is filled
+	boost::mutex reorderMutex;
+	std::map<size_t, std::shared_ptr<AbcPreparedSample>> reorder;
+	size_t nextFrame;
+	//a thread is committing this object's samples, the others only queue theirs
+	bool committing;
 };
 
+//! Creates the param an encoded FLOAT (extent 1) or VECTOR (extent 3) property is stored in
+static void setupEncodedProperty(AbcWriterImp& data, Alembic::AbcGeom::OCompoundProperty& arbGeomPs,
+	const std::string& name, size_t extent, AbcWriterPropertySlot& slot)
+{
+	Alembic::Abc::MetaData metaData;
+	metaData.set(ABC_TYPE_KEY, extent == 3 ? "vector" : "float");
+	switch(slot.encoding)
+	{
+	case ENCODE_HALF:
+		metaData.set(ABC_ENCODING_KEY, "half");
+		slot.paramIdx = data.halfParams.size();
+		data.halfParams.emplace_back(arbGeomPs, name, false, slot.scope, extent, metaData);
+		break;
+	case ENCODE_QUANTIZED16:
+	{
+		//the ranges change every sample, they go into the schema's user properties
+		const std::string rangeName = name + "_range";
+		metaData.set(ABC_ENCODING_KEY, "quantized16");
+		metaData.set(ABC_RANGE_KEY, rangeName);
+		slot.paramIdx = data.quantizedParams.size();
+		data.quantizedParams.emplace_back(arbGeomPs, name, false, slot.scope, extent, metaData);
+		data.quantizedRanges.emplace_back(data.mesh->getSchema().getUserProperties(), rangeName);
+		break;
+	}
+	case ENCODE_UNORM8:
+		metaData.set(ABC_ENCODING_KEY, "unorm8");
+		if(extent == 3)
+		{
+			slot.paramIdx = data.colour8Params.size();
+			data.colour8Params.emplace_back(arbGeomPs, name, false, slot.scope, 1, metaData);
+		}
+		else
+		{
+			slot.paramIdx = data.unorm8Params.size();
+			data.unorm8Params.emplace_back(arbGeomPs, name, false, slot.scope, 1, metaData);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
 void AbcWriter::setupObject(const std::string& xFormName, const std::string& meshName,
-		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>& arbGeoProperties)
 {
 	m_data.emplace_back(std::make_shared<AbcWriterImp>());
 	m_data.back()->transform = std::make_shared<Alembic::AbcGeom::OXform>(Alembic::Abc::OObject(m_archive->getTop()), xFormName);
@@ -24,13 +164,10 @@ void AbcWriter::setupObject(const std::string& xFormName, const std::string& mes
 	m_floatParams.push_back(std::vector<Alembic::AbcGeom::OFloatGeomParam>{});
 	m_vectorParams.push_back(std::vector<Alembic::AbcGeom::OV3fGeomParam>{});
 	m_colourParams.push_back(std::vector<Alembic::AbcGeom::OC3fGeomParam>{});
-	m_arbScopes.push_back(std::vector<Alembic::AbcGeom::GeometryScope>{});
-	m_arbNames.push_back(std::vector<std::string>{});
+	AbcWriterImp& data = *m_data.back();
 
 	Alembic::AbcGeom::OCompoundProperty arbGeomPs = m_data.back()->mesh->getSchema().getArbGeomParams();
 	//create custom properties
-	std::vector<std::string> vectorPropNames;
-	std::vector<Alembic::AbcGeom::GeometryScope> vectorPropScopes;
 	for(auto& p : arbGeoProperties)
 	{
 		Alembic::AbcGeom::GeometryScope scope;
@@ -51,24 +188,54 @@ void AbcWriter::setupObject(const std::string& xFormName, const std::string& mes
 			std::cout << "ERROR: Unknown scope detected, this may crash. (" << std::get<0>(p) << ")" << std::endl;
 		}
 
+		AbcWriterPropertySlot slot;
+		slot.name = std::get<0>(p);
+		slot.scope = scope;
+		slot.isColour = false;
+		slot.encoding = std::get<3>(p);
+		slot.created = true;
+		slot.indexed = false;
+		if(slot.encoding != ENCODE_FLOAT32 && std::get<1>(p) != PROP_TYPE::FLOAT && std::get<1>(p) != PROP_TYPE::VECTOR)
+		{
+			std::cout << "ERROR: Only FLOAT and VECTOR properties can be encoded, it will be written as is. (" << std::get<0>(p) << ")" << std::endl;
+			slot.encoding = ENCODE_FLOAT32;
+		}
+
 		if(std::get<1>(p) == PROP_TYPE::FLOAT)
 		{
-			m_floatParams.back().emplace_back(arbGeomPs, std::get<0>(p), false, scope, 1); 
-			m_arbScopes.back().push_back(scope);
-			m_arbNames.back().push_back(std::get<0>(p));
+			if(slot.encoding != ENCODE_FLOAT32)
+			{
+				setupEncodedProperty(data, arbGeomPs, std::get<0>(p), 1, slot);
+			}
+			else
+			{
+				slot.paramIdx = m_floatParams.back().size();
+				m_floatParams.back().emplace_back(arbGeomPs, std::get<0>(p), false, scope, 1); 
+			}
+			data.propertySlots.emplace(std::get<0>(p), std::make_pair(FLOAT, (int)data.floatSlots.size()));
+			data.floatSlots.push_back(slot);
 		}
 		else if(std::get<1>(p) == PROP_TYPE::VECTOR)
 		{
-			if(std::get<0>(p) == "Cd")
+			if(slot.encoding != ENCODE_FLOAT32)
+			{
+				setupEncodedProperty(data, arbGeomPs, std::get<0>(p), 3, slot);
+			}
+			else if(std::get<0>(p) == "Cd")
 			{
-				m_colourParams.back().emplace_back(arbGeomPs, std::get<0>(p), false, scope, 1);
+				slot.isColour = true;
+				slot.created = false;
+				slot.paramIdx = m_colourParams.back().size();
+				m_colourParams.back().emplace_back();
 			}
 			else
 			{
-				m_vectorParams.back().emplace_back(arbGeomPs, std::get<0>(p), false, scope, 1);
+				slot.created = false;
+				slot.paramIdx = m_vectorParams.back().size();
+				m_vectorParams.back().emplace_back();
 			}
-			vectorPropScopes.push_back(scope);
-			vectorPropNames.push_back(std::get<0>(p));
+			data.propertySlots.emplace(std::get<0>(p), std::make_pair(VECTOR, (int)data.vectorSlots.size()));
+			data.vectorSlots.push_back(slot);
 		}
 		else
 		{
@@ -76,14 +243,100 @@ void AbcWriter::setupObject(const std::string& xFormName, const std::string& mes
 			continue;
 		}
 	}
+}
+
+int AbcWriter::findPropertySlot(const std::string& name, PROP_TYPE type, size_t meshIdx) const
+{
+	const AbcWriterImp& data = *m_data[meshIdx];
+	auto it = data.propertySlots.find(name);
+	if(it == data.propertySlots.end() || it->second.first != type)
+	{
+		std::cout << "ERROR: Property " << name << " was not declared with this type for mesh " << m_objectName[meshIdx] << std::endl;
+		return -1;
+	}
+	return it->second.second;
+}
+
+AbcWriterSample AbcWriter::createSample(size_t meshIdx) const
+{
+	AbcWriterSample sample(meshIdx);
+	if(meshIdx >= m_data.size())
+	{
+		std::cout << "ERROR: Mesh index " << meshIdx << " out of range! Sample has no properties." << std::endl;
+		return sample;
+	}
+	sample.floatProps.resize(m_data[meshIdx]->floatSlots.size());
+	sample.vectorProps.resize(m_data[meshIdx]->vectorSlots.size());
+	sample.vectorPropsSoA.resize(m_data[meshIdx]->vectorSlots.size());
+	return sample;
+}
+
+AbcWriterSample AbcWriter::createSample(const AbcSample& decoded, size_t meshIdx) const
+{
+	AbcWriterSample sample = createSample(meshIdx);
+	sample.vertices = decoded.positions;
+	sample.faceIndices = decoded.faceIndices;
+	sample.faceCounts = decoded.faceCounts;
+	if(!decoded.normals.empty())
+	{
+		//one normal per face corner is facevarying, anything else per point
+		sample.setNormals(decoded.normals, decoded.normals.size() == decoded.faceIndices.size() ? FACE : VERTEX);
+	}
+	for(size_t i = 0; i < sample.floatProps.size() && i < decoded.floatProperties.size(); ++i)
+	{
+		sample.floatProps[i] = decoded.floatProperties[i];
+	}
+	for(size_t i = 0; i < sample.vectorProps.size() && i < decoded.vectorProperties.size(); ++i)
+	{
+		sample.vectorProps[i] = decoded.vectorProperties[i];
+	}
+	if(!decoded.selfBounds.isEmpty())
+	{
+		sample.setSelfBounds(decoded.selfBounds);
+	}
+	return sample;
+}
+
+//! Plain float declarations
+static std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>
+withoutEncoding(const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+{
+	std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>> properties;
+	for(auto& p : arbGeoProperties)
+	{
+		properties.emplace_back(std::get<0>(p), std::get<1>(p), std::get<2>(p), ENCODE_FLOAT32);
+	}
+	return properties;
+}
+
+static std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>>
+withoutEncoding(const std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>>& arbGeoProperties)
+{
+	std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>> properties;
+	for(auto& mesh : arbGeoProperties)
+	{
+		properties.push_back(withoutEncoding(mesh));
+	}
+	return properties;
+}
+
+AbcWriter::AbcWriter(const std::string& file, const std::string& xFormName, const std::string& meshName,
+		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties)
+	: AbcWriter(file, xFormName, meshName, withoutEncoding(arbGeoProperties))
+{
+}
 
-	m_arbNames.back().insert(m_arbNames.back().end(), vectorPropNames.begin(), vectorPropNames.end());
-	m_arbScopes.back().insert(m_arbScopes.back().end(), vectorPropScopes.begin(), vectorPropScopes.end());
+AbcWriter::AbcWriter(const std::string& file, const std::vector<std::string>& xFormNames, const std::vector<std::string>& meshNames,
+		const std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>>& arbGeoProperties)
+	: AbcWriter(file, xFormNames, meshNames, withoutEncoding(arbGeoProperties))
+{
 }
 
 AbcWriter::AbcWriter(const std::string& file, const std::string& xFormName, const std::string& meshName,
-		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties) : m_archiveName(file)
+		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>& arbGeoProperties) : m_archiveName(file), m_fileIsOpen(false), m_writeChildBounds(false), m_autoIndexRatio(0.0),
+	m_normalsMode(NORMALS_FROM_FILE), m_generatedNormalsScope(POINT)
 {
+	m_stats = std::make_shared<AbcStats>(file);
 	m_objectName.push_back(meshName);
 	m_archive= std::make_shared<Alembic::Abc::OArchive>(Alembic::AbcCoreOgawa::WriteArchive(), m_archiveName);
 
@@ -96,8 +349,10 @@ AbcWriter::AbcWriter(const std::string& file, const std::string& xFormName, cons
 }
 
 AbcWriter::AbcWriter(const std::string& file, const std::vector<std::string>& xFormNames, const std::vector<std::string>& meshNames,
-		const std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>>& arbGeoProperties) : m_archiveName(file)
+		const std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>>& arbGeoProperties) : m_archiveName(file), m_fileIsOpen(false), m_writeChildBounds(false), m_autoIndexRatio(0.0),
+	m_normalsMode(NORMALS_FROM_FILE), m_generatedNormalsScope(POINT)
 {
+	m_stats = std::make_shared<AbcStats>(file);
 	m_archive= std::make_shared<Alembic::Abc::OArchive>(Alembic::AbcCoreOgawa::WriteArchive(), m_archiveName);
 
 	for(auto i = 0;  i < meshNames.size(); ++i)
@@ -114,11 +369,16 @@ AbcWriter::AbcWriter(const std::string& file, const std::vector<std::string>& xF
 
 AbcWriter::~AbcWriter()
 {
+	//every queued sample has to hit the archive before it is closed
+	flush();
+	m_writeQueue.reset();
+
 	if (m_fileIsOpen)
 	{
 		std::cout << "Closing [ " << m_archive->getName() << " ]" << std::endl;
 		for(auto i = 0; i < m_data.size(); ++i)
 		{
+			createVectorParams(i, nullptr);
 			std::cout << "# samples saved for mesh " << m_objectName[i] << ": "
 			<< m_data[i]->mesh->getSchema().getNumSamples() << std::endl;
 		}
@@ -126,9 +386,203 @@ AbcWriter::~AbcWriter()
 }
 
 
+//! Encodes count scalars of a FLOAT (extent 1) or VECTOR (extent 3) property into out
+static void encodeProperty(const AbcWriterPropertySlot& slot, const float* values, size_t count, int extent, AbcPreparedProperty& out)
+{
+	switch(slot.encoding)
+	{
+	case ENCODE_HALF:
+		out.half.resize(count);
+		encodeHalf(values, count, out.half.data());
+		break;
+	case ENCODE_QUANTIZED16:
+		componentRange(values, count, extent, &out.range.min.x, &out.range.max.x);
+		out.quantized.resize(count);
+		quantize16(values, count, extent, &out.range.min.x, &out.range.max.x, out.quantized.data());
+		break;
+	case ENCODE_UNORM8:
+		out.unorm8.resize(count);
+		encodeUnorm8(values, count, out.unorm8.data());
+		break;
+	default:
+		break;
+	}
+}
+
+//! Sets the param of an encoded property
+static void writeEncodedProperty(AbcWriterImp& data, const AbcWriterPropertySlot& slot, const AbcPreparedProperty& property, int extent)
+{
+	switch(slot.encoding)
+	{
+	case ENCODE_HALF:
+	{
+		Alembic::AbcGeom::OHalfGeomParam::Sample halfSamp;
+		halfSamp.setScope(slot.scope);
+		halfSamp.setVals(Alembic::Abc::HalfArraySample(property.half.data(), property.half.size()));
+		data.halfParams[slot.paramIdx].set(halfSamp);
+		break;
+	}
+	case ENCODE_QUANTIZED16:
+	{
+		Alembic::AbcGeom::OUInt16GeomParam::Sample quantizedSamp;
+		quantizedSamp.setScope(slot.scope);
+		quantizedSamp.setVals(Alembic::Abc::UInt16ArraySample(property.quantized.data(), property.quantized.size()));
+		data.quantizedParams[slot.paramIdx].set(quantizedSamp);
+		data.quantizedRanges[slot.paramIdx].set(property.range);
+		break;
+	}
+	case ENCODE_UNORM8:
+	{
+		if(extent == 3)
+		{
+			Alembic::AbcGeom::OC3cGeomParam::Sample colourSamp;
+			colourSamp.setScope(slot.scope);
+			colourSamp.setVals(Alembic::Abc::C3cArraySample((const Alembic::Abc::C3c*)property.unorm8.data(), property.unorm8.size() / 3));
+			data.colour8Params[slot.paramIdx].set(colourSamp);
+		}
+		else
+		{
+			Alembic::AbcGeom::OUcharGeomParam::Sample unorm8Samp;
+			unorm8Samp.setScope(slot.scope);
+			unorm8Samp.setVals(Alembic::Abc::UcharArraySample(property.unorm8.data(), property.unorm8.size()));
+			data.unorm8Params[slot.paramIdx].set(unorm8Samp);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+//! Owned copy of a view, for samples that outlive the caller's buffers
+template <typename T>
+static AbcArrayView<T> ownedCopy(const AbcArrayView<T>& view, AbcStats& stats)
+{
+	if(view.owner() || view.empty())
+	{
+		return view;
+	}
+	stats.addAllocations(1);
+	return AbcArrayView<T>::adopt(view.toVector());
+}
+
+static AbcSoAVector3 ownedCopy(const AbcSoAVector3& soa, AbcStats& stats)
+{
+	AbcSoAVector3 owned;
+	owned.x = ownedCopy(soa.x, stats);
+	owned.y = ownedCopy(soa.y, stats);
+	owned.z = ownedCopy(soa.z, stats);
+	return owned;
+}
+
+//! The interleaved values of a V3f attribute, SoA input is interleaved into scratch first
+static AbcArrayView<Alembic::Abc::V3f> interleaved(const AbcArrayView<Alembic::Abc::V3f>& values, const AbcSoAVector3& soa,
+	std::vector<Alembic::Abc::V3f>& scratch)
+{
+	if(soa.empty())
+	{
+		return values;
+	}
+	fromSoA(soa, scratch);
+	return AbcArrayView<Alembic::Abc::V3f>(scratch);
+}
+
+//! Copy of sample that owns all its buffers
+static AbcWriterSample ownedSample(const AbcWriterSample& sample, AbcStats& stats)
+{
+	AbcWriterSample owned(sample);
+	owned.vertices = ownedCopy(sample.vertices, stats);
+	owned.faceIndices = ownedCopy(sample.faceIndices, stats);
+	owned.faceCounts = ownedCopy(sample.faceCounts, stats);
+	owned.normals = ownedCopy(sample.normals, stats);
+	for(auto& p : owned.floatProps)
+	{
+		p = ownedCopy(p, stats);
+	}
+	for(auto& p : owned.vectorProps)
+	{
+		p = ownedCopy(p, stats);
+	}
+	owned.verticesSoA = ownedCopy(sample.verticesSoA, stats);
+	owned.normalsSoA = ownedCopy(sample.normalsSoA, stats);
+	for(auto& p : owned.vectorPropsSoA)
+	{
+		p = ownedCopy(p, stats);
+	}
+	return owned;
+}
+
+bool AbcWriterSample::hasSlot(int slot, size_t count) const
+{
+	if(slot < 0 || slot >= (int)count)
+	{
+		std::cout << "ERROR: Property slot " << slot << " is not declared for mesh " << meshIdx << ", it is ignored." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+size_t AbcWriterSample::numBytes() const
+{
+	size_t bytes = vertices.size() * sizeof(Alembic::Abc::V3f) + normals.size() * sizeof(Alembic::Abc::V3f)
+		+ (faceIndices.size() + faceCounts.size()) * sizeof(int);
+	for(auto& p : floatProps)
+	{
+		bytes += p.size() * sizeof(float);
+	}
+	for(auto& p : vectorProps)
+	{
+		bytes += p.size() * sizeof(Alembic::Abc::V3f);
+	}
+	bytes += (verticesSoA.size() + normalsSoA.size()) * sizeof(Alembic::Abc::V3f);
+	for(auto& p : vectorPropsSoA)
+	{
+		bytes += p.size() * sizeof(Alembic::Abc::V3f);
+	}
+	return bytes;
+}
+
+void AbcWriter::setAsync(size_t maxQueuedSamples, size_t maxQueuedBytes)
+{
+	//drain the old queue first so no sample overtakes another
+	flush();
+	m_writeQueue.reset();
+
+	if(maxQueuedSamples > 0)
+	{
+		m_writeQueue = std::make_shared<AbcWriteQueue>(maxQueuedSamples, maxQueuedBytes);
+	}
+}
+
+bool AbcWriter::flush()
+{
+	bool ok = true;
+	if(m_writeQueue)
+	{
+		ok = m_writeQueue->flush();
+		for(auto& error : m_writeQueue->takeErrors())
+		{
+			std::cout << "ERROR: Asynchronous write to Alembic Archive [" << m_archiveName << "] failed: " << error << std::endl;
+		}
+	}
+
+	//samples of addSample(sample, frame) stuck behind a frame that never came
+	for(size_t i = 0; i < m_data.size(); ++i)
+	{
+		AbcWriterImp& data = *m_data[i];
+		boost::unique_lock<boost::mutex> lock(data.reorderMutex);
+		if(!data.reorder.empty())
+		{
+			std::cout << "ERROR: " << data.reorder.size() << " samples of mesh " << m_objectName[i]
+				<< " are waiting for frame " << data.nextFrame << ", which was never added." << std::endl;
+			ok = false;
+		}
+	}
+	return ok;
+}
+
 bool
-AbcWriter::addSample(std::vector<Alembic::Abc::V3f>& vertices, std::vector<int>& faceIndices,
-	std::vector<int>& faceCounts, size_t meshIdx)
+AbcWriter::submitSample(const AbcWriterSample& sample)
 {
 	// Make sure that our file is open
 	if (!m_fileIsOpen)
@@ -138,117 +592,414 @@ AbcWriter::addSample(std::vector<Alembic::Abc::V3f>& vertices, std::vector<int>&
 		return false;
 	}
 
-	//get schema
-	Alembic::AbcGeom::OPolyMeshSchema& schema = m_data[meshIdx]->mesh->getSchema();
+	if(!m_writeQueue)
+	{
+		return writeSample(sample);
+	}
 
-	//create a sample
-	Alembic::AbcGeom::OPolyMeshSchema::Sample sample;
+	//the caller may reuse its buffers as soon as we return, so the queued sample must own its data
+	std::shared_ptr<AbcWriterSample> owned = std::make_shared<AbcWriterSample>(ownedSample(sample, *m_stats));
 
-	//POSITION
-	sample.setPositions(Alembic::Abc::P3fArraySample(&vertices[0], vertices.size()));
+	AbcStatsTimer timer(*m_stats, WRITE_QUEUE_WAIT);
+	m_writeQueue->push([this, owned]() { writeSample(*owned); }, owned->numBytes());
+	return true;
+}
+
+bool
+AbcWriter::addSample(const AbcWriterSample& sample)
+{
+	if(sample.meshIdx >= m_data.size())
+	{
+		std::cout << "ERROR: Mesh index " << sample.meshIdx << " out of range! Sample could not be written." << std::endl;
+		return false;
+	}
+	return submitSample(sample);
+}
 
-	//FACE-INDICES
-	sample.setFaceIndices(Alembic::Abc::Int32ArraySample(&faceIndices[0], faceIndices.size()));
+bool
+AbcWriter::addSample(std::vector<Alembic::Abc::V3f>& vertices, std::vector<int>& faceIndices,
+	std::vector<int>& faceCounts, size_t meshIdx)
+{
+	AbcWriterSample sample(meshIdx);
+	sample.vertices = vertices;
+	sample.faceIndices = faceIndices;
+	sample.faceCounts = faceCounts;
 
-	//FACE COUNTS
-	sample.setFaceCounts(Alembic::Abc::Int32ArraySample(&faceCounts[0], faceCounts.size()));
+	return submitSample(sample);
+}
 
-	//set mesh sample
-	schema.set(sample);
+bool
+AbcWriter::addSample(std::vector<Alembic::Abc::V3f>&& vertices, std::vector<int>&& faceIndices,
+	std::vector<int>&& faceCounts, size_t meshIdx)
+{
+	AbcWriterSample sample(meshIdx);
+	sample.vertices = AbcArrayView<Alembic::Abc::V3f>::adopt(std::move(vertices));
+	sample.faceIndices = AbcArrayView<int>::adopt(std::move(faceIndices));
+	sample.faceCounts = AbcArrayView<int>::adopt(std::move(faceCounts));
 
-	return true;
+	return submitSample(sample);
 }
 
 bool
 AbcWriter::addSample(const std::vector<Alembic::Abc::V3f>& vertices,
 		const std::vector<int>& faceIndices, const std::vector<int>& faceCounts,
 		const std::vector<Alembic::Abc::V3f>& normals, PROP_SCOPE normalsScope,
-		const std::vector<std::vector<float>> floatProps,
-		const std::vector<std::vector<Alembic::Abc::V3f>> vectorProps,
+		const std::vector<std::vector<float>>& floatProps,
+		const std::vector<std::vector<Alembic::Abc::V3f>>& vectorProps,
 		size_t meshIdx)
 {
-	Alembic::AbcGeom::GeometryScope normalScope;
-	if(normalsScope == POINT)
-	{
-		normalScope = Alembic::AbcGeom::GeometryScope::kVaryingScope;
-	}
-	else if(normalsScope == VERTEX)
+	AbcWriterSample sample(meshIdx);
+	sample.vertices = vertices;
+	sample.faceIndices = faceIndices;
+	sample.faceCounts = faceCounts;
+	sample.hasNormals = true;
+	sample.normals = normals;
+	sample.normalsScope = normalsScope;
+	sample.floatProps.assign(floatProps.begin(), floatProps.end());
+	sample.vectorProps.assign(vectorProps.begin(), vectorProps.end());
+
+	return submitSample(sample);
+}
+
+bool
+AbcWriter::addSample(std::vector<Alembic::Abc::V3f>&& vertices,
+		std::vector<int>&& faceIndices, std::vector<int>&& faceCounts,
+		std::vector<Alembic::Abc::V3f>&& normals, PROP_SCOPE normalsScope,
+		std::vector<std::vector<float>>&& floatProps,
+		std::vector<std::vector<Alembic::Abc::V3f>>&& vectorProps,
+		size_t meshIdx)
+{
+	AbcWriterSample sample(meshIdx);
+	sample.vertices = AbcArrayView<Alembic::Abc::V3f>::adopt(std::move(vertices));
+	sample.faceIndices = AbcArrayView<int>::adopt(std::move(faceIndices));
+	sample.faceCounts = AbcArrayView<int>::adopt(std::move(faceCounts));
+	sample.hasNormals = true;
+	sample.normals = AbcArrayView<Alembic::Abc::V3f>::adopt(std::move(normals));
+	sample.normalsScope = normalsScope;
+	for(auto& p : floatProps)
 	{
-		normalScope = Alembic::AbcGeom::GeometryScope::kVertexScope;
+		sample.floatProps.push_back(AbcArrayView<float>::adopt(std::move(p)));
 	}
-	else if(normalsScope == FACE)
+	for(auto& p : vectorProps)
 	{
-		normalScope = Alembic::AbcGeom::GeometryScope::kFacevaryingScope;
+		sample.vectorProps.push_back(AbcArrayView<Alembic::Abc::V3f>::adopt(std::move(p)));
 	}
-	else
+
+	return submitSample(sample);
+}
+
+bool
+AbcWriter::addSample(const AbcWriterSample& in, size_t frame)
+{
+	if(in.meshIdx >= m_data.size())
 	{
-		std::cout << "ERROR: Unknown normal scope detected, this may crash." << std::endl;
+		std::cout << "ERROR: Mesh index " << in.meshIdx << " out of range! Sample could not be written." << std::endl;
+		return false;
 	}
-
-	// Make sure that our file is open
 	if (!m_fileIsOpen)
 	{
 		std::cout << "ERROR: Alembic Archive [" <<
 			m_archiveName << "] is not open! Sample could not be written." << std::endl;
 		return false;
 	}
+	if(m_writeQueue)
+	{
+		std::cout << "ERROR: Samples with a frame cannot be written asynchronously, the queue would reorder them." << std::endl;
+		return false;
+	}
 
-	//get schema
-	Alembic::AbcGeom::OPolyMeshSchema& schema = m_data[meshIdx]->mesh->getSchema();
+	AbcStatsTimer sampleTimer(*m_stats, WRITE_SAMPLE);
+	AbcWriterImp& data = *m_data[in.meshIdx];
 
-	//create a sample
-	Alembic::AbcGeom::OPolyMeshSchema::Sample sample;
+	//all the heavy lifting runs on the calling thread, concurrently with every other caller.
+	//The sample may wait for earlier frames, so it cannot point at the caller's buffers.
+	std::shared_ptr<AbcPreparedSample> prepared = std::make_shared<AbcPreparedSample>();
+	prepareSample(ownedSample(in, *m_stats), *prepared, false);
+
+	boost::unique_lock<boost::mutex> lock(data.reorderMutex);
+	if(frame < data.nextFrame || data.reorder.count(frame))
+	{
+		std::cout << "ERROR: Frame " << frame << " of mesh " << m_objectName[in.meshIdx] << " was already added! Sample could not be written." << std::endl;
+		return false;
+	}
+	data.reorder[frame] = prepared;
+
+	//whoever completes the next frame in line commits it and everything that queued up behind it
+	if(data.committing)
+	{
+		return true;
+	}
+	data.committing = true;
+	bool ok = true;
+	while(!data.reorder.empty() && data.reorder.begin()->first == data.nextFrame)
+	{
+		std::shared_ptr<AbcPreparedSample> next = data.reorder.begin()->second;
+		data.reorder.erase(data.reorder.begin());
+		++data.nextFrame;
+
+		lock.unlock();
+		try
+		{
+			ok = commitSample(*next) && ok;
+		}
+		catch(...)
+		{
+			lock.lock();
+			data.committing = false;
+			throw;
+		}
+		lock.lock();
+	}
+	data.committing = false;
+	return ok;
+}
+
+bool
+AbcWriter::writeSample(const AbcWriterSample& in)
+{
+	AbcStatsTimer sampleTimer(*m_stats, WRITE_SAMPLE);
+
+	//only one thread writes synchronously or asynchronously, it owns the scratch buffers
+	AbcPreparedSample& prepared = m_data[in.meshIdx]->scratch;
+	prepareSample(in, prepared, true);
+	return commitSample(prepared);
+}
+
+void
+AbcWriter::prepareSample(const AbcWriterSample& in, AbcPreparedSample& out, bool serial)
+{
+	AbcStatsTimer setupTimer(*m_stats, WRITE_SETUP);
+	AbcWriterImp& data = *m_data[in.meshIdx];
+	out.meshIdx = in.meshIdx;
+	out.numBytes = in.numBytes();
 
 	//GENERIC------------------------------------------------------------------------
 	//POSITION
-	sample.setPositions(Alembic::Abc::P3fArraySample(&vertices[0], vertices.size()));
+	out.vertices = interleaved(in.vertices, in.verticesSoA, out.interleavedVertices);
 
-	//FACE-INDICES
-	sample.setFaceIndices(Alembic::Abc::Int32ArraySample(&faceIndices[0], faceIndices.size()));
+	//BOUNDS
+	//without them alembic runs its own scalar loop over the positions
+	out.bounds = in.hasSelfBounds ? in.selfBounds : computeBounds(out.vertices);
 
-	//FACE COUNTS
-	sample.setFaceCounts(Alembic::Abc::Int32ArraySample(&faceCounts[0], faceCounts.size()));
+	//FACE-INDICES, FACE COUNTS
+	out.faceIndices = in.faceIndices;
+	out.faceCounts = in.faceCounts;
 
 	//NORMALS
+	const bool generateNormals = m_normalsMode == NORMALS_GENERATE_ALWAYS
+		|| (m_normalsMode == NORMALS_GENERATE_MISSING && !in.hasNormals);
+	out.hasNormals = in.hasNormals || generateNormals;
+	out.normals = AbcArrayView<Alembic::Abc::V3f>();
+	if(out.hasNormals)
+	{
+		const PROP_SCOPE normalsScope = generateNormals ? m_generatedNormalsScope : in.normalsScope;
+		if(normalsScope == POINT)
+		{
+			out.normalsScope = Alembic::AbcGeom::GeometryScope::kVaryingScope;
+		}
+		else if(normalsScope == VERTEX)
+		{
+			out.normalsScope = Alembic::AbcGeom::GeometryScope::kVertexScope;
+		}
+		else if(normalsScope == FACE)
+		{
+			out.normalsScope = Alembic::AbcGeom::GeometryScope::kFacevaryingScope;
+		}
+		else
+		{
+			std::cout << "ERROR: Unknown normal scope detected, this may crash." << std::endl;
+		}
+
+		out.normals = generateNormals ?
+			data.normalGenerator.compute(out.vertices, in.faceIndices, in.faceCounts, normalsScope)
+			: interleaved(in.normals, in.normalsSoA, out.interleavedNormals);
+	}
+
+	setupTimer.stop();
+
+	//CUSTOM------------------------------------------------------------------------
+	AbcStatsTimer propertiesTimer(*m_stats, WRITE_PROPERTIES);
+	out.floatProps.resize(std::min(in.floatProps.size(), data.floatSlots.size()));
+	for(size_t i = 0; i < out.floatProps.size(); ++i)
+	{
+		const AbcWriterPropertySlot& slot = data.floatSlots[i];
+		AbcPreparedProperty& property = out.floatProps[i];
+		property.floats = in.floatProps[i];
+		if(slot.encoding != ENCODE_FLOAT32)
+		{
+			encodeProperty(slot, in.floatProps[i].data(), in.floatProps[i].size(), 1, property);
+		}
+	}
+
+	out.vectorProps.resize(std::min(in.vectorProps.size(), data.vectorSlots.size()));
+	for(size_t i = 0; i < out.vectorProps.size(); ++i)
+	{
+		const AbcWriterPropertySlot& slot = data.vectorSlots[i];
+		AbcPreparedProperty& property = out.vectorProps[i];
+		property.vectors = i < in.vectorPropsSoA.size() ?
+			interleaved(in.vectorProps[i], in.vectorPropsSoA[i], property.interleaved) : in.vectorProps[i];
+		property.haveIndices = false;
+		if(slot.encoding != ENCODE_FLOAT32)
+		{
+			encodeProperty(slot, (const float*)property.vectors.data(), property.vectors.size() * 3, 3, property);
+			continue;
+		}
+
+		//INDEXING
+		//the first sample decides, a failed attempt stops hashing as soon as there are too many distinct values.
+		//Concurrent samples cannot see that decision yet and always try, commitSample sorts them out.
+		const size_t numValues = property.vectors.size();
+		const bool decided = serial && slot.created;
+		if(decided ? slot.indexed : m_autoIndexRatio > 0.0 && numValues > 0)
+		{
+			const size_t maxUnique = decided ? numValues : (size_t)(numValues * m_autoIndexRatio);
+			property.haveIndices = indexValues(property.vectors.data(), numValues, maxUnique, property.unique, property.indices);
+		}
+	}
+}
+
+void
+AbcWriter::createVectorParams(size_t meshIdx, const AbcPreparedSample* sample)
+{
+	AbcWriterImp& data = *m_data[meshIdx];
+	Alembic::AbcGeom::OCompoundProperty arbGeomPs = data.mesh->getSchema().getArbGeomParams();
+	for(size_t i = 0; i < data.vectorSlots.size(); ++i)
+	{
+		AbcWriterPropertySlot& slot = data.vectorSlots[i];
+		if(slot.created)
+		{
+			continue;
+		}
+
+		//declared params exist even if the first sample leaves them out, they are never indexed without auto-indexing
+		slot.indexed = m_autoIndexRatio > 0.0 && sample && i < sample->vectorProps.size() && sample->vectorProps[i].haveIndices;
+		if(slot.isColour)
+		{
+			m_colourParams[meshIdx][slot.paramIdx] = Alembic::AbcGeom::OC3fGeomParam(arbGeomPs, slot.name, slot.indexed, slot.scope, 1);
+		}
+		else
+		{
+			m_vectorParams[meshIdx][slot.paramIdx] = Alembic::AbcGeom::OV3fGeomParam(arbGeomPs, slot.name, slot.indexed, slot.scope, 1);
+		}
+		slot.created = true;
+	}
+}
+
+bool
+AbcWriter::commitSample(AbcPreparedSample& in)
+{
+	const size_t meshIdx = in.meshIdx;
+
+	//objects share the archive's stream, one sample is written at a time
+	AbcStatsTimer waitTimer(*m_stats, WRITE_COMMIT_WAIT);
+	boost::unique_lock<boost::mutex> lock(m_archiveMutex);
+	waitTimer.stop();
+
+	//get schema
+	AbcWriterImp& data = *m_data[meshIdx];
+	Alembic::AbcGeom::OPolyMeshSchema& schema = data.mesh->getSchema();
+
+	//create a sample
+	Alembic::AbcGeom::OPolyMeshSchema::Sample sample;
+	sample.setPositions(Alembic::Abc::P3fArraySample(in.vertices.data(), in.vertices.size()));
+	sample.setSelfBounds(in.bounds);
+	if(m_writeChildBounds)
+	{
+		if(!data.childBounds.valid())
+		{
+			data.childBounds = data.transform->getSchema().getChildBoundsProperty();
+		}
+		data.childBounds.set(in.bounds);
+	}
+
+	//unset face indices and counts are written with setFromPrevious, which skips hashing them again
+	const bool sameTopology = data.haveTopology
+		&& sameContents(data.lastFaceCounts, in.faceCounts) && sameContents(data.lastFaceIndices, in.faceIndices);
+	if(!sameTopology)
+	{
+		sample.setFaceIndices(Alembic::Abc::Int32ArraySample(in.faceIndices.data(), in.faceIndices.size()));
+		sample.setFaceCounts(Alembic::Abc::Int32ArraySample(in.faceCounts.data(), in.faceCounts.size()));
+		data.lastFaceIndices = ownedCopy(in.faceIndices, *m_stats);
+		data.lastFaceCounts = ownedCopy(in.faceCounts, *m_stats);
+		data.haveTopology = true;
+	}
+
 	Alembic::AbcGeom::ON3fGeomParam::Sample normalsSamp;
-	normalsSamp.setScope(normalScope);
-	normalsSamp.setVals(Alembic::AbcGeom::N3fArraySample(&normals.front(), normals.size()));
-	sample.setNormals(normalsSamp);
+	if(in.hasNormals)
+	{
+		normalsSamp.setScope(in.normalsScope);
+		normalsSamp.setVals(Alembic::AbcGeom::N3fArraySample(in.normals.data(), in.normals.size()));
+		sample.setNormals(normalsSamp);
+	}
 
 	//CUSTOM------------------------------------------------------------------------
-	//std::cout << "Writing Float Props..." << std::endl;
-	for(size_t i = 0; i < floatProps.size(); ++i)
+	AbcStatsTimer propertiesTimer(*m_stats, WRITE_PROPERTIES);
+	for(size_t i = 0; i < in.floatProps.size(); ++i)
 	{
-		//std::cout << m_arbNames[i] << std::endl;
+		const AbcWriterPropertySlot& slot = data.floatSlots[i];
+		const AbcPreparedProperty& property = in.floatProps[i];
+		if(slot.encoding != ENCODE_FLOAT32)
+		{
+			writeEncodedProperty(data, slot, property, 1);
+			continue;
+		}
 		Alembic::AbcGeom::OFloatGeomParam::Sample floatSamp;
-		floatSamp.setScope(m_arbScopes[meshIdx][i]);
-		floatSamp.setVals(Alembic::AbcGeom::FloatArraySample(&floatProps[i].front(), floatProps[i].size()));
-		m_floatParams[meshIdx][i].set(floatSamp);
+		floatSamp.setScope(slot.scope);
+		floatSamp.setVals(Alembic::AbcGeom::FloatArraySample(property.floats.data(), property.floats.size()));
+		m_floatParams[meshIdx][slot.paramIdx].set(floatSamp);
 	}
 
-	//std::cout << "Writing Colour Props..." << std::endl;
-	size_t colourIdx = 0;
-	for(size_t i = 0; i < vectorProps.size(); ++i)
+	createVectorParams(meshIdx, &in);
+	for(size_t i = 0; i < in.vectorProps.size(); ++i)
 	{
-		//std::cout <<  m_arbNames[floatProps.size() + i] << std::endl;
-		if(m_arbNames[meshIdx][floatProps.size() + i] == "Cd")
+		AbcWriterPropertySlot& slot = data.vectorSlots[i];
+		AbcPreparedProperty& property = in.vectorProps[i];
+		if(slot.encoding != ENCODE_FLOAT32)
+		{
+			writeEncodedProperty(data, slot, property, 3);
+			continue;
+		}
+
+		//INDEXING
+		//a concurrent sample that gave up hashing before the first one decided to index
+		if(slot.indexed && !property.haveIndices)
+		{
+			indexValues(property.vectors.data(), property.vectors.size(), property.vectors.size(), property.unique, property.indices);
+		}
+		const Alembic::Abc::UInt32ArraySample indices(property.indices.data(), slot.indexed ? property.indices.size() : 0);
+		const AbcArrayView<Alembic::Abc::V3f> values = slot.indexed ? AbcArrayView<Alembic::Abc::V3f>(property.unique) : property.vectors;
+
+		if(slot.isColour)
 		{
 			Alembic::AbcGeom::OC3fGeomParam::Sample vectorSamp;
-			vectorSamp.setScope(m_arbScopes[meshIdx][floatProps.size() + i]);
-			vectorSamp.setVals(Alembic::AbcGeom::C3fArraySample( (const Imath::C3f *) &vectorProps[i].front(), vectorProps[i].size()));
-			m_colourParams[meshIdx][colourIdx].set(vectorSamp);
-			++colourIdx;
+			vectorSamp.setScope(slot.scope);
+			vectorSamp.setVals(Alembic::AbcGeom::C3fArraySample( (const Imath::C3f *) values.data(), values.size()));
+			if(slot.indexed)
+			{
+				vectorSamp.setIndices(indices);
+			}
+			m_colourParams[meshIdx][slot.paramIdx].set(vectorSamp);
 			continue;
 		}
 		Alembic::AbcGeom::OV3fGeomParam::Sample vectorSamp;
-		vectorSamp.setScope(m_arbScopes[meshIdx][floatProps.size() + i + colourIdx]);
-		vectorSamp.setVals(Alembic::AbcGeom::V3fArraySample(&vectorProps[i].front(), vectorProps[i].size()));
-		m_vectorParams[meshIdx][i - colourIdx].set(vectorSamp);
+		vectorSamp.setScope(slot.scope);
+		vectorSamp.setVals(Alembic::AbcGeom::V3fArraySample(values.data(), values.size()));
+		if(slot.indexed)
+		{
+			vectorSamp.setIndices(indices);
+		}
+		m_vectorParams[meshIdx][slot.paramIdx].set(vectorSamp);
 	}
 
+	propertiesTimer.stop();
+
 	//set mesh sample
-	schema.set(sample);
+	{
+		AbcStatsTimer timer(*m_stats, WRITE_SCHEMA_SET);
+		schema.set(sample);
+	}
 
+	m_stats->addBytesWritten(in.numBytes);
 	return true;
 }
 
@@ -256,8 +1007,6 @@ AbcWriter::addSample(const std::vector<Alembic::Abc::V3f>& vertices,
 void AbcWriter::addXFormSample(const Alembic::Abc::V3d& translate, const Alembic::Abc::V3d& scale, 
 	const double angleInDegreesX, const double angleInDegreesY, const double angleInDegreesZ, size_t meshIdx)
 {
-	Alembic::AbcGeom::OXformSchema& schema = m_data[meshIdx]->transform->getSchema();
-
 	Alembic::AbcGeom::XformSample sample;
 
 	sample.setTranslation(translate);
@@ -266,30 +1015,44 @@ void AbcWriter::addXFormSample(const Alembic::Abc::V3d& translate, const Alembic
 	sample.setYRotation(angleInDegreesY);
 	sample.setZRotation(angleInDegreesZ);
 
-	schema.set(sample);
+	writeXFormSample(sample, meshIdx);
 }
 
 void AbcWriter::addXFormSample(const Alembic::Abc::V3d& translate, const Alembic::Abc::V3d& scale, 
 	const Alembic::Abc::V3d& rotationAxis, const double angleInDegrees, size_t meshIdx)
 {
-	Alembic::AbcGeom::OXformSchema& schema = m_data[meshIdx]->transform->getSchema();
-
 	Alembic::AbcGeom::XformSample sample;
 
 	sample.setTranslation(translate);
 	sample.setScale(scale);
 	sample.setRotation(rotationAxis, angleInDegrees);
 
-	schema.set(sample);
+	writeXFormSample(sample, meshIdx);
 }
 
 void AbcWriter::addXFormSample(const Alembic::Abc::M44d& transformMatrix, size_t meshIdx)
 {
-	Alembic::AbcGeom::OXformSchema& schema = m_data[meshIdx]->transform->getSchema();
-
 	Alembic::AbcGeom::XformSample sample;
 
 	sample.setMatrix(transformMatrix);
 
-	schema.set(sample);
+	writeXFormSample(sample, meshIdx);
+}
+
+void AbcWriter::writeXFormSample(const Alembic::AbcGeom::XformSample& sample, size_t meshIdx)
+{
+	if(!m_writeQueue)
+	{
+		boost::unique_lock<boost::mutex> lock(m_archiveMutex);
+		Alembic::AbcGeom::XformSample s(sample);
+		m_data[meshIdx]->transform->getSchema().set(s);
+		return;
+	}
+
+	//queued behind the mesh samples, the archive is only ever touched by one thread
+	m_writeQueue->push([this, sample, meshIdx]()
+	{
+		Alembic::AbcGeom::XformSample s(sample);
+		m_data[meshIdx]->transform->getSchema().set(s);
+	}, sizeof(sample));
 }
\ No newline at end of file
@@ -4,12 +4,86 @@
 #include <vector>
 #include <memory>
 
+#include <boost/thread/mutex.hpp>
+
 #include <Alembic/Abc/All.h>
 #include <Alembic/AbcGeom/All.h>
 
 #include "easyAbcUtil.h"
+#include "AbcSample.h"
+#include "AbcProperty.h"
+#include "AbcWriteQueue.h"
+#include "AbcStats.h"
 
 struct AbcWriterImp;
+struct AbcPreparedSample;
+
+//! One mesh sample on its way to the archive, filled in place by the caller (see AbcWriter::createSample).
+//! The views either point at the caller's buffers or own their data once the sample has been queued for an asynchronous write.
+struct AbcWriterSample
+{
+	explicit AbcWriterSample(size_t mesh = 0) : meshIdx(mesh), hasNormals(false), normalsScope(VERTEX), hasSelfBounds(false) {}
+
+	size_t numBytes() const;
+
+	void setNormals(const AbcArrayView<Alembic::Abc::V3f>& values, PROP_SCOPE scope)
+	{
+		hasNormals = true;
+		normals = values;
+		normalsScope = scope;
+	}
+
+	//! handle comes from AbcWriter::getPropertyHandle for the same mesh
+	//! Invalid handles, or handles of another mesh's properties, are reported and ignored
+	void setProperty(const AbcPropertyHandle<float>& handle, const AbcArrayView<float>& values)
+	{
+		if(hasSlot(handle.slot(), floatProps.size())) floatProps[handle.slot()] = values;
+	}
+	void setProperty(const AbcPropertyHandle<Alembic::Abc::V3f>& handle, const AbcArrayView<Alembic::Abc::V3f>& values)
+	{
+		if(hasSlot(handle.slot(), vectorProps.size())) vectorProps[handle.slot()] = values;
+	}
+
+	//! Bounds the caller already knows, otherwise they are computed from the vertices
+	void setSelfBounds(const Alembic::Abc::Box3d& bounds)
+	{
+		hasSelfBounds = true;
+		selfBounds = bounds;
+	}
+
+	//SoA input, interleaved when the sample is written. Takes precedence over the interleaved views.
+	void setVertices(const AbcSoAVector3& values) { verticesSoA = values; }
+	void setNormals(const AbcSoAVector3& values, PROP_SCOPE scope)
+	{
+		hasNormals = true;
+		normalsSoA = values;
+		normalsScope = scope;
+	}
+	void setProperty(const AbcPropertyHandle<Alembic::Abc::V3f>& handle, const AbcSoAVector3& values)
+	{
+		if(hasSlot(handle.slot(), vectorPropsSoA.size())) vectorPropsSoA[handle.slot()] = values;
+	}
+
+	size_t meshIdx;
+	AbcArrayView<Alembic::Abc::V3f> vertices;
+	AbcArrayView<int> faceIndices;
+	AbcArrayView<int> faceCounts;
+	bool hasNormals;
+	AbcArrayView<Alembic::Abc::V3f> normals;
+	PROP_SCOPE normalsScope;
+	std::vector<AbcArrayView<float>> floatProps;
+	std::vector<AbcArrayView<Alembic::Abc::V3f>> vectorProps;
+	bool hasSelfBounds;
+	Alembic::Abc::Box3d selfBounds;
+
+	AbcSoAVector3 verticesSoA;
+	AbcSoAVector3 normalsSoA;
+	std::vector<AbcSoAVector3> vectorPropsSoA;
+
+private:
+	//! False (and an error printed) if slot is not one of count slots
+	bool hasSlot(int slot, size_t count) const;
+};
 
 class AbcWriter
 {
@@ -20,16 +94,86 @@ public:
 	AbcWriter(const std::string& file, const std::vector<std::string>& xFormNames, const std::vector<std::string>& meshNames,
 		const std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>>& arbGeoProperties);
 
+	//! Same as above with an encoding per property. FLOAT and VECTOR properties can be stored as half floats,
+	//! 16 bit fixed point against each sample's range, or 8 bit [0, 1] (colours). AbcReader decodes them transparently.
+	AbcWriter(const std::string& file, const std::string& xFormName, const std::string& meshName,
+		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>& arbGeoProperties);
+
+	AbcWriter(const std::string& file, const std::vector<std::string>& xFormNames, const std::vector<std::string>& meshNames,
+		const std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>>& arbGeoProperties);
+
+	//! Waits for pending asynchronous writes and reports their errors
 	~AbcWriter();
 
+	//! Write samples on a background thread. addSample returns as soon as the sample is queued and
+	//! blocks while maxQueuedSamples (or maxQueuedBytes, 0 = no limit) are pending. 0 samples = synchronous.
+	void setAsync(size_t maxQueuedSamples, size_t maxQueuedBytes = 0);
+	bool isAsync() const { return m_writeQueue != nullptr; }
+	//! Wait until all queued samples are written. Returns false (and prints why) if any of them failed,
+	//! or if samples added with a frame still wait for an earlier one.
+	bool flush();
+
+	//! Also store each mesh sample's bounds as child bounds of its transform. Set before the first sample.
+	void setWriteChildBounds(bool write) { m_writeChildBounds = write; }
+
+	//! Write VECTOR properties whose first sample has at most maxUniqueRatio distinct values per element as indexed
+	//! GeomParams, unique values plus an index per element (0 = off). FLOAT properties are always written expanded,
+	//! their uint32 indices alone would be as large as the values. Set before the first sample.
+	void setAutoIndex(double maxUniqueRatio) { m_autoIndexRatio = maxUniqueRatio; }
+
+	//! Emit N generated from the vertices and topology when a sample has none (or always, replacing the given ones)
+	void setNormalsMode(NORMALS_MODE mode, PROP_SCOPE scope = POINT)
+	{
+		m_normalsMode = mode;
+		m_generatedNormalsScope = scope;
+	}
+
+	//! Per-phase timings, latency histograms, bytes written and allocations of this writer
+	AbcStatsSnapshot getStats() const { return m_stats->snapshot(); }
+	void resetStats() { m_stats->reset(); }
+	void setStatsEnabled(bool enabled) { m_stats->setEnabled(enabled); }
+	//! Print the stats to std::cout every seconds while samples are written (0 = off)
+	void setStatsDumpInterval(double seconds) { m_stats->setDumpInterval(seconds); }
+
+	//! Resolve a declared FLOAT (T = float) or VECTOR (T = V3f) property once, for AbcWriterSample::setProperty
+	template <typename T>
+	AbcPropertyHandle<T> getPropertyHandle(const std::string& name, size_t meshIdx = 0) const
+	{
+		return AbcPropertyHandle<T>(findPropertySlot(name, AbcPropertyTraits<T>::type, meshIdx));
+	}
+
+	//! A sample with one empty slot per declared property, to be filled through views without copying
+	AbcWriterSample createSample(size_t meshIdx = 0) const;
+	//! A sample viewing the buffers of a decoded one, for copying meshes between archives. The reader has to have been
+	//! opened with the same property list, properties are matched by slot. One normal per face corner is facevarying.
+	AbcWriterSample createSample(const AbcSample& decoded, size_t meshIdx = 0) const;
+	bool addSample(const AbcWriterSample& sample);
+
+	//! Thread-safe: any number of threads may add samples of any mesh, in any order. Interleaving, bounds, normals,
+	//! encoding and index hashing run on the calling thread in parallel with the others. Each mesh's samples are then
+	//! written strictly by frame, 0, 1, 2, ..., a sample that arrives early waits in a per-mesh reorder buffer
+	//! (holding a copy of its buffers) and is written by whichever thread adds the frame before it.
+	//! Do not mix with the other addSample overloads or setAsync for the same writer.
+	bool addSample(const AbcWriterSample& sample, size_t frame);
+
+	//In asynchronous mode the lvalue overloads copy the buffers, the rvalue overloads take them over
 	bool addSample(std::vector<Alembic::Abc::V3f>& vertices,
 		std::vector<int>& faceIndices, std::vector<int>& faceCounts, size_t meshIdx = 0);
 
+	bool addSample(std::vector<Alembic::Abc::V3f>&& vertices,
+		std::vector<int>&& faceIndices, std::vector<int>&& faceCounts, size_t meshIdx = 0);
+
 	bool addSample(const std::vector<Alembic::Abc::V3f>& vertices,
 		const std::vector<int>& faceIndices, const std::vector<int>& faceCounts,
 		const std::vector<Alembic::Abc::V3f>& normals, PROP_SCOPE normalsScope,
-		const std::vector<std::vector<float>> floatProps,
-		const std::vector<std::vector<Alembic::Abc::V3f>> vectorProps, size_t meshIdx = 0);
+		const std::vector<std::vector<float>>& floatProps,
+		const std::vector<std::vector<Alembic::Abc::V3f>>& vectorProps, size_t meshIdx = 0);
+
+	bool addSample(std::vector<Alembic::Abc::V3f>&& vertices,
+		std::vector<int>&& faceIndices, std::vector<int>&& faceCounts,
+		std::vector<Alembic::Abc::V3f>&& normals, PROP_SCOPE normalsScope,
+		std::vector<std::vector<float>>&& floatProps,
+		std::vector<std::vector<Alembic::Abc::V3f>>&& vectorProps, size_t meshIdx = 0);
 	
 	// Three different ways to write a transform sample
 	//! Order of ops: translate, scale, rotateX, rotateY, rotateZ
@@ -44,11 +188,23 @@ public:
 
 private:
 	void setupObject(const std::string& xFormName, const std::string& meshName,
-		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& arbGeoProperties);
+		const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>& arbGeoProperties);
+	int findPropertySlot(const std::string& name, PROP_TYPE type, size_t meshIdx) const;
+	bool submitSample(const AbcWriterSample& sample);
+	bool writeSample(const AbcWriterSample& sample);
+	void prepareSample(const AbcWriterSample& in, AbcPreparedSample& out, bool serial);
+	bool commitSample(AbcPreparedSample& sample);
+	void createVectorParams(size_t meshIdx, const AbcPreparedSample* sample);
+	void writeXFormSample(const Alembic::AbcGeom::XformSample& sample, size_t meshIdx);
+
 	std::string m_archiveName;
 	std::vector<std::string> m_objectName;
 
 	bool m_fileIsOpen;
+	bool m_writeChildBounds;
+	double m_autoIndexRatio;
+	NORMALS_MODE m_normalsMode;
+	PROP_SCOPE m_generatedNormalsScope;
 
 	std::shared_ptr<Alembic::Abc::OArchive> m_archive;
 	std::vector<std::shared_ptr<AbcWriterImp>> m_data;
@@ -57,7 +213,10 @@ private:
 	std::vector<std::vector<Alembic::AbcGeom::OFloatGeomParam>> m_floatParams;
 	std::vector<std::vector<Alembic::AbcGeom::OV3fGeomParam>> m_vectorParams;
 	std::vector<std::vector<Alembic::AbcGeom::OC3fGeomParam>> m_colourParams;
-	std::vector<std::vector<Alembic::AbcGeom::GeometryScope>> m_arbScopes;
-	std::vector<std::vector<std::string>> m_arbNames;
+
+	std::shared_ptr<AbcWriteQueue> m_writeQueue;
+	//held while anything is written to the archive
+	boost::mutex m_archiveMutex;
+	std::shared_ptr<AbcStats> m_stats;
 };
 
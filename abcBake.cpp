@@ -0,0 +1,94 @@
+#include <string>
+#include <iostream>
+#include <vector>
+#include <tuple>
+#include <cstdlib>
+
+#include "AbcReader.h"
+#include "AbcBakeCache.h"
+
+//Converts a mesh of an .abc archive to a memory-mappable bake cache, or checks a cache against its archive.
+//Usage: abcBake bake <file.abc> <xForm> <mesh> <cache.bake> [-r begin end] [-p name:type ...]
+//       abcBake validate <file.abc> <xForm> <mesh> <cache.bake> [-p name:type ...]
+//type is one of float, vector, int, vector2, quat
+
+static int usage(const char* program)
+{
+	std::cerr << "Usage: " << program << " bake <file.abc> <xForm> <mesh> <cache.bake> [-r begin end] [-p name:type ...]" << std::endl
+		<< "       " << program << " validate <file.abc> <xForm> <mesh> <cache.bake> [-p name:type ...]" << std::endl
+		<< "type is one of float, vector, int, vector2, quat" << std::endl;
+	return 1;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 6)
+	{
+		return usage(argv[0]);
+	}
+
+	std::string mode(argv[1]);
+	std::string abcFile(argv[2]);
+	std::string xFormName(argv[3]);
+	std::string meshName(argv[4]);
+	std::string bakeFile(argv[5]);
+
+	std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> properties;
+	int begin = 0;
+	int end = -1;
+	for(int i = 6; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		if(arg == "-p" && i + 1 < argc && parsePropertySpec(argv[i + 1], properties))
+		{
+			++i;
+		}
+		else if(arg == "-r" && i + 2 < argc)
+		{
+			begin = std::atoi(argv[i + 1]);
+			end = std::atoi(argv[i + 2]);
+			i += 2;
+		}
+		else
+		{
+			return usage(argv[0]);
+		}
+	}
+
+	AbcReader reader;
+	if(!reader.openArchive(abcFile, xFormName, meshName, properties))
+	{
+		return 1;
+	}
+
+	if(mode == "bake")
+	{
+		if(end < 0)
+		{
+			end = reader.getNumSamples();
+		}
+		if(!bakeArchive(reader, bakeFile, begin, end))
+		{
+			return 1;
+		}
+		std::cout << "Baked samples [" << begin << ", " << end << ") of " << meshName << " to [ " << bakeFile << " ]" << std::endl;
+		return 0;
+	}
+
+	if(mode == "validate")
+	{
+		AbcBakeReader bake;
+		if(!bake.open(bakeFile))
+		{
+			return 1;
+		}
+		if(!validateBake(reader, bake))
+		{
+			return 1;
+		}
+		std::cout << "[ " << bakeFile << " ] matches " << bake.getNumSamples() << " samples of " << meshName << std::endl;
+		return 0;
+	}
+
+	return usage(argv[0]);
+}
@@ -0,0 +1,81 @@
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <tuple>
+#include <cstdlib>
+#include <algorithm>
+
+#include "AbcMerge.h"
+#include "AbcProperty.h"
+
+//Merges per-frame archives (one sample each, e.g. written by a farm job per frame) into one animated archive.
+//Usage: abcMerge <out.abc> <xForm> <mesh> [-n prefetch] [-l list.txt] [-p name:type ...] [frame.abc ...]
+//Frames are written in the order given, type is one of float, vector
+
+static int usage(const char* program)
+{
+	std::cerr << "Usage: " << program << " <out.abc> <xForm> <mesh> [-n prefetch] [-l list.txt] [-p name:type ...] [frame.abc ...]" << std::endl
+		<< "type is one of float, vector" << std::endl;
+	return 1;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 5)
+	{
+		return usage(argv[0]);
+	}
+
+	std::string outFile(argv[1]);
+	std::string xFormName(argv[2]);
+	std::string meshName(argv[3]);
+
+	std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> properties;
+	std::vector<std::string> frames;
+	size_t prefetch = 0;
+	for(int i = 4; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		if(arg == "-p" && i + 1 < argc && parsePropertySpec(argv[i + 1], properties))
+		{
+			++i;
+		}
+		else if(arg == "-n" && i + 1 < argc)
+		{
+			prefetch = (size_t)std::max(1, std::atoi(argv[++i]));
+		}
+		else if(arg == "-l" && i + 1 < argc)
+		{
+			std::ifstream list(argv[++i]);
+			if(!list)
+			{
+				std::cout << "ERROR: Frame list [" << argv[i] << "] could not be opened!" << std::endl;
+				return 1;
+			}
+			std::string line;
+			while(std::getline(list, line))
+			{
+				if(!line.empty())
+				{
+					frames.push_back(line);
+				}
+			}
+		}
+		else if(!arg.empty() && arg[0] != '-')
+		{
+			frames.push_back(arg);
+		}
+		else
+		{
+			return usage(argv[0]);
+		}
+	}
+
+	if(!mergeArchives(frames, outFile, xFormName, meshName, properties, prefetch))
+	{
+		return 1;
+	}
+	std::cout << "Merged " << frames.size() << " frames of " << meshName << " to [ " << outFile << " ]" << std::endl;
+	return 0;
+}
@@ -0,0 +1,440 @@
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <tuple>
+#include <set>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+#include <sys/stat.h>
+
+#include <boost/thread/mutex.hpp>
+
+#include "AbcReader.h"
+#include "AbcWriter.h"
+#include "AbcArchiveIndex.h"
+#include "AbcArchivePool.h"
+#include "AbcThreadPool.h"
+
+//Rewrites many .abc archives (HDF5 or Ogawa) as compact Ogawa archives, several files at a time.
+//Usage: abcTranscode -o <outDir> [-l list.txt] [-r begin end] [-j files] [--keep a,b,... | --drop a,b,...]
+//                    [--encoding float32|half|quantized16] [--index ratio] [--journal file] [file.abc ...]
+//Every mesh sitting directly below a transform under the top object is copied with its transform and its
+//float and vector attributes. Finished files are appended to the journal (<outDir>/abcTranscode.journal),
+//a later run with the same journal skips them, so an interrupted batch picks up where it stopped.
+
+typedef std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> PropertyList;
+
+struct TranscodeOptions
+{
+	TranscodeOptions() : begin(0), end(-1), numFiles(2), keep(false), encoding(ENCODE_FLOAT32), indexRatio(0.0) {}
+
+	std::string outDir;
+	std::string journal;
+	int begin;
+	int end;
+	size_t numFiles;
+	//keep: only the listed attributes, otherwise all but the listed ones
+	bool keep;
+	std::set<std::string> attributes;
+	PROP_ENCODING encoding;
+	double indexRatio;
+};
+
+static int usage(const char* program)
+{
+	std::cerr << "Usage: " << program << " -o <outDir> [-l list.txt] [-r begin end] [-j files] [--keep a,b,... | --drop a,b,...]" << std::endl
+		<< "       [--encoding float32|half|quantized16] [--index ratio] [--journal file] [file.abc ...]" << std::endl;
+	return 1;
+}
+
+static std::set<std::string> splitNames(const std::string& list)
+{
+	std::set<std::string> names;
+	std::stringstream stream(list);
+	std::string name;
+	while(std::getline(stream, name, ','))
+	{
+		if(!name.empty())
+		{
+			names.insert(name);
+		}
+	}
+	return names;
+}
+
+static bool fileExists(const std::string& file)
+{
+	struct stat info;
+	return stat(file.c_str(), &info) == 0;
+}
+
+static std::string baseName(const std::string& file)
+{
+	size_t slash = file.find_last_of('/');
+	return slash == std::string::npos ? file : file.substr(slash + 1);
+}
+
+static double secondsSince(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! Appends finished outputs, one per line, and remembers the ones finished by earlier runs
+class TranscodeJournal
+{
+public:
+	explicit TranscodeJournal(const std::string& file) : m_file(file)
+	{
+		std::ifstream in(file);
+		std::string line;
+		while(std::getline(in, line))
+		{
+			if(!line.empty())
+			{
+				m_done.insert(line);
+			}
+		}
+	}
+
+	//! Finished earlier, and the output is still there
+	bool isDone(const std::string& output) const
+	{
+		return m_done.count(output) && fileExists(output);
+	}
+
+	void markDone(const std::string& output)
+	{
+		boost::unique_lock<boost::mutex> lock(m_mutex);
+		std::ofstream out(m_file, std::ios::app);
+		out << output << std::endl;
+	}
+
+private:
+	std::string m_file;
+	std::set<std::string> m_done;
+	boost::mutex m_mutex;
+};
+
+//! One mesh to copy, with the transform it sits below
+struct TranscodeMesh
+{
+	const AbcObjectInfo* xForm;
+	const AbcObjectInfo* mesh;
+	PropertyList properties;
+};
+
+static void findMeshes(const AbcArchiveIndex& index, const TranscodeOptions& options, const std::string& file,
+	std::vector<TranscodeMesh>& meshes)
+{
+	const std::vector<AbcObjectInfo>& objects = index.getObjects();
+	std::set<const AbcObjectInfo*> xForms;
+	for(auto& object : objects)
+	{
+		if(object.type != OBJECT_POLYMESH)
+		{
+			continue;
+		}
+
+		//AbcWriter writes /xForm/mesh pairs, anything nested deeper or not below a transform has no place in them
+		const AbcObjectInfo* parent = object.parent < 0 ? nullptr : &objects[object.parent];
+		if(!parent || parent->type != OBJECT_XFORM || parent->parent != 0)
+		{
+			std::cout << "WARNING: Skipping mesh " << object.path << " of [" << file << "], it is not directly below a top level transform." << std::endl;
+			continue;
+		}
+		if(!xForms.insert(parent).second)
+		{
+			std::cout << "WARNING: Skipping mesh " << object.path << " of [" << file << "], AbcWriter writes one mesh per transform." << std::endl;
+			continue;
+		}
+
+		TranscodeMesh mesh;
+		mesh.xForm = parent;
+		mesh.mesh = &object;
+		for(auto& p : object.properties)
+		{
+			if(options.attributes.count(p.name) != (options.keep ? 1u : 0u))
+			{
+				continue;
+			}
+			//AbcWriter only writes float and vector attributes
+			if(p.type != FLOAT && p.type != VECTOR)
+			{
+				std::cout << "WARNING: Skipping attribute " << p.name << " of " << object.path << ", only float and vector attributes are transcoded." << std::endl;
+				continue;
+			}
+			//and only per point, vertex or face corner, uniform and constant ones would be written with the wrong element count
+			if(p.alembicScope != Alembic::AbcGeom::kVaryingScope && p.alembicScope != Alembic::AbcGeom::kVertexScope
+				&& p.alembicScope != Alembic::AbcGeom::kFacevaryingScope)
+			{
+				std::cout << "WARNING: Skipping attribute " << p.name << " of " << object.path << ", its scope cannot be written." << std::endl;
+				continue;
+			}
+			mesh.properties.emplace_back(p.name, p.type, p.scope);
+		}
+		meshes.push_back(mesh);
+	}
+}
+
+//! Copies every sample of meshIdx from the reader into writer, frames renumbered from options.begin
+static bool transcodeMesh(const AbcArchiveIndex& index, const TranscodeMesh& mesh, const TranscodeOptions& options,
+	AbcWriter& writer, size_t meshIdx, size_t& numSamples)
+{
+	//the transform's samples in the same range first, the writer keeps them apart from the mesh
+	Alembic::AbcGeom::IXform xForm(mesh.xForm->object, Alembic::AbcGeom::kWrapExisting);
+	Alembic::AbcGeom::IXformSchema& xFormSchema = xForm.getSchema();
+	const size_t numXFormSamples = xFormSchema.getNumSamples();
+	const size_t xFormEnd = options.end < 0 ? numXFormSamples : std::min((size_t)options.end, numXFormSamples);
+	for(size_t i = (size_t)options.begin; i < xFormEnd; ++i)
+	{
+		Alembic::AbcGeom::XformSample xFormSample;
+		xFormSchema.get(xFormSample, Alembic::Abc::ISampleSelector((Alembic::Abc::index_t)i));
+		writer.addXFormSample(xFormSample.getMatrix(), meshIdx);
+	}
+
+	AbcReader reader;
+	if(!reader.openArchive(index, mesh.mesh->path, mesh.properties))
+	{
+		return false;
+	}
+
+	const int end = options.end < 0 ? reader.getNumSamples() : std::min(options.end, reader.getNumSamples());
+	bool ok = true;
+	reader.readRange(options.begin, end, [&](const AbcSample& in)
+	{
+		//reader and writer were given the same list, so their slots match
+		AbcWriterSample out = writer.createSample(in, meshIdx);
+		ok = writer.addSample(out, (size_t)(in.index - options.begin)) && ok;
+		++numSamples;
+	});
+	return ok;
+}
+
+//! Writes file to output through a temporary file, so an interrupted run never leaves a partial output behind
+static bool transcodeFile(const std::string& file, const std::string& output, const TranscodeOptions& options,
+	AbcThreadPool& pool, size_t& numSamples, uint64_t& bytesWritten)
+{
+	AbcArchiveIndex index;
+	if(!index.build(file, true))
+	{
+		return false;
+	}
+
+	std::vector<TranscodeMesh> meshes;
+	findMeshes(index, options, file, meshes);
+	if(meshes.empty())
+	{
+		std::cout << "ERROR: No mesh of [" << file << "] can be transcoded." << std::endl;
+		return false;
+	}
+
+	std::vector<std::string> xFormNames;
+	std::vector<std::string> meshNames;
+	std::vector<std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>>> properties;
+	for(auto& mesh : meshes)
+	{
+		xFormNames.push_back(mesh.xForm->name);
+		meshNames.push_back(mesh.mesh->name);
+		properties.emplace_back();
+		for(auto& p : mesh.properties)
+		{
+			properties.back().emplace_back(std::get<0>(p), std::get<1>(p), std::get<2>(p), options.encoding);
+		}
+	}
+
+	const std::string tmp = output + ".tmp";
+	bool ok = true;
+	{
+		AbcWriter writer(tmp, xFormNames, meshNames, properties);
+		writer.setAutoIndex(options.indexRatio);
+
+		std::vector<size_t> meshSamples(meshes.size(), 0);
+		std::vector<char> meshOk(meshes.size(), 0);
+		pool.parallelFor(meshes.size(), [&](size_t i)
+		{
+			meshOk[i] = transcodeMesh(index, meshes[i], options, writer, i, meshSamples[i]);
+		});
+
+		ok = writer.flush();
+		for(size_t i = 0; i < meshes.size(); ++i)
+		{
+			numSamples += meshSamples[i];
+			ok = ok && meshOk[i];
+		}
+		bytesWritten = writer.getStats().bytesWritten;
+	}
+
+	if(!ok || std::rename(tmp.c_str(), output.c_str()) != 0)
+	{
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	TranscodeOptions options;
+	std::vector<std::string> files;
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		if(arg == "-o" && i + 1 < argc)
+		{
+			options.outDir = argv[++i];
+		}
+		else if(arg == "-l" && i + 1 < argc)
+		{
+			std::ifstream list(argv[++i]);
+			if(!list)
+			{
+				std::cout << "ERROR: File list [" << argv[i] << "] could not be opened!" << std::endl;
+				return 1;
+			}
+			std::string line;
+			while(std::getline(list, line))
+			{
+				if(!line.empty())
+				{
+					files.push_back(line);
+				}
+			}
+		}
+		else if(arg == "-r" && i + 2 < argc)
+		{
+			options.begin = std::max(0, std::atoi(argv[i + 1]));
+			options.end = std::atoi(argv[i + 2]);
+			i += 2;
+		}
+		else if(arg == "-j" && i + 1 < argc)
+		{
+			options.numFiles = (size_t)std::max(1, std::atoi(argv[++i]));
+		}
+		else if((arg == "--keep" || arg == "--drop") && i + 1 < argc)
+		{
+			options.keep = arg == "--keep";
+			options.attributes = splitNames(argv[++i]);
+		}
+		else if(arg == "--encoding" && i + 1 < argc)
+		{
+			std::string encoding(argv[++i]);
+			if(encoding == "float32") options.encoding = ENCODE_FLOAT32;
+			else if(encoding == "half") options.encoding = ENCODE_HALF;
+			else if(encoding == "quantized16") options.encoding = ENCODE_QUANTIZED16;
+			else return usage(argv[0]);
+		}
+		else if(arg == "--index" && i + 1 < argc)
+		{
+			options.indexRatio = std::atof(argv[++i]);
+		}
+		else if(arg == "--journal" && i + 1 < argc)
+		{
+			options.journal = argv[++i];
+		}
+		else if(!arg.empty() && arg[0] != '-')
+		{
+			files.push_back(arg);
+		}
+		else
+		{
+			return usage(argv[0]);
+		}
+	}
+
+	if(options.outDir.empty() || files.empty())
+	{
+		return usage(argv[0]);
+	}
+	if(options.journal.empty())
+	{
+		options.journal = options.outDir + "/abcTranscode.journal";
+	}
+
+	TranscodeJournal journal(options.journal);
+	std::vector<std::pair<std::string, std::string>> jobs;
+	std::map<std::string, std::string> inputs;
+	size_t numSkipped = 0;
+	for(auto& file : files)
+	{
+		//inputs of the same name from different directories would write, and journal, the same output
+		std::string output = options.outDir + "/" + baseName(file);
+		auto input = inputs.emplace(output, file);
+		if(!input.second)
+		{
+			if(input.first->second == file)
+			{
+				continue;
+			}
+			std::cout << "ERROR: [" << input.first->second << "] and [" << file << "] would both be written to [" << output << "]." << std::endl;
+			return 1;
+		}
+		if(journal.isDone(output))
+		{
+			++numSkipped;
+			continue;
+		}
+		jobs.emplace_back(file, output);
+	}
+	std::cout << "Transcoding " << jobs.size() << " files, " << numSkipped << " already done." << std::endl;
+
+	//every file decodes on the default pool, opened with as many streams as it has workers
+	AbcArchivePool::defaultPool().setNumStreams(AbcThreadPool::defaultPool().getNumThreads());
+
+	//files in flight, and with them the samples held by readers and reorder buffers, are bounded by the pool size
+	AbcThreadPool filePool(options.numFiles);
+	std::atomic<size_t> numDone(0);
+	std::atomic<size_t> numFailed(0);
+	std::atomic<uint64_t> totalBytes(0);
+	boost::mutex printMutex;
+	const auto start = std::chrono::steady_clock::now();
+
+	filePool.parallelFor(jobs.size(), [&](size_t i)
+	{
+		const std::string& file = jobs[i].first;
+		const std::string& output = jobs[i].second;
+		const auto fileStart = std::chrono::steady_clock::now();
+
+		size_t numSamples = 0;
+		uint64_t bytesWritten = 0;
+		bool ok = false;
+		try
+		{
+			ok = transcodeFile(file, output, options, filePool, numSamples, bytesWritten);
+		}
+		catch(const std::exception& e)
+		{
+			std::cout << "ERROR: Transcoding [" << file << "] failed: " << e.what() << std::endl;
+			std::remove((output + ".tmp").c_str());
+		}
+		AbcArchivePool::defaultPool().closeIdle();
+
+		if(ok)
+		{
+			journal.markDone(output);
+			totalBytes += bytesWritten;
+		}
+		else
+		{
+			++numFailed;
+		}
+
+		const double seconds = secondsSince(fileStart);
+		boost::unique_lock<boost::mutex> lock(printMutex);
+		std::cout << "[" << ++numDone << "/" << jobs.size() << "] " << (ok ? "" : "FAILED ") << file << ": "
+			<< numSamples << " samples, " << bytesWritten / 1e6 << " MB in " << seconds << " s ("
+			<< (seconds > 0.0 ? bytesWritten / 1e6 / seconds : 0.0) << " MB/s)" << std::endl;
+	});
+
+	const double seconds = secondsSince(start);
+	std::cout << "Transcoded " << jobs.size() - numFailed << " of " << jobs.size() << " files, " << totalBytes / 1e6 << " MB in "
+		<< seconds << " s (" << (seconds > 0.0 ? totalBytes / 1e6 / seconds : 0.0) << " MB/s)" << std::endl;
+	return numFailed ? 1 : 0;
+}
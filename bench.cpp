@@ -0,0 +1,391 @@
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <tuple>
+
+#include "AbcReader.h"
+#include "AbcWriter.h"
+
+//Benchmarks the hot paths of AbcWriter/AbcReader on procedurally generated meshes.
+//Usage: easyAbcBench [--sizes 1000,100000] [--frames 10] [--float-props 2] [--vector-props 2]
+//                    [--topology-changes] [--format csv|json] [--dir /tmp] [--output file]
+
+struct BenchOptions
+{
+	std::vector<size_t> sizes;
+	int frames;
+	int numFloatProps;
+	int numVectorProps;
+	bool topologyChanges;
+	std::string format;
+	std::string dir;
+	std::string output;
+};
+
+//results of timed loops end up here, so the compiler cannot drop the work
+static volatile double g_benchSink = 0.0;
+
+struct BenchResult
+{
+	std::string name;
+	size_t points;
+	int samples;
+	double seconds;
+	double bytes;
+};
+
+//! Grid mesh of roughly numPoints points with a per-frame wave and some attributes
+struct SyntheticMesh
+{
+	std::vector<Alembic::Abc::V3f> positions;
+	std::vector<int> faceIndices;
+	std::vector<int> faceCounts;
+	std::vector<Alembic::Abc::V3f> normals;
+	std::vector<std::vector<float>> floatProps;
+	std::vector<std::vector<Alembic::Abc::V3f>> vectorProps;
+
+	double numBytes() const
+	{
+		double bytes = positions.size() * sizeof(Alembic::Abc::V3f) * 2 + (faceIndices.size() + faceCounts.size()) * sizeof(int);
+		for(auto& p : floatProps)
+		{
+			bytes += p.size() * sizeof(float);
+		}
+		for(auto& p : vectorProps)
+		{
+			bytes += p.size() * sizeof(Alembic::Abc::V3f);
+		}
+		return bytes;
+	}
+};
+
+static void generateMesh(SyntheticMesh& mesh, size_t numPoints, int frame, const BenchOptions& options)
+{
+	//changing the resolution every other frame changes the topology
+	size_t res = std::max<size_t>(2, (size_t)std::sqrt((double)numPoints));
+	if(options.topologyChanges && frame % 2 == 1)
+	{
+		res -= 1;
+	}
+
+	mesh.positions.resize(res * res);
+	mesh.normals.resize(res * res);
+	for(size_t y = 0; y < res; ++y)
+	{
+		for(size_t x = 0; x < res; ++x)
+		{
+			float fx = (float)x / res;
+			float fy = (float)y / res;
+			mesh.positions[y * res + x] = Alembic::Abc::V3f(fx, std::sin(fx * 10.0f + frame * 0.1f) * 0.1f, fy);
+			mesh.normals[y * res + x] = Alembic::Abc::V3f(0.0f, 1.0f, 0.0f);
+		}
+	}
+
+	mesh.faceCounts.assign((res - 1) * (res - 1), 4);
+	mesh.faceIndices.resize(mesh.faceCounts.size() * 4);
+	size_t f = 0;
+	for(size_t y = 0; y + 1 < res; ++y)
+	{
+		for(size_t x = 0; x + 1 < res; ++x)
+		{
+			mesh.faceIndices[f++] = y * res + x;
+			mesh.faceIndices[f++] = (y + 1) * res + x;
+			mesh.faceIndices[f++] = (y + 1) * res + x + 1;
+			mesh.faceIndices[f++] = y * res + x + 1;
+		}
+	}
+
+	mesh.floatProps.resize(options.numFloatProps);
+	for(int i = 0; i < options.numFloatProps; ++i)
+	{
+		mesh.floatProps[i].resize(mesh.positions.size());
+		for(size_t j = 0; j < mesh.positions.size(); ++j)
+		{
+			mesh.floatProps[i][j] = mesh.positions[j].y * (i + 1);
+		}
+	}
+
+	mesh.vectorProps.resize(options.numVectorProps);
+	for(int i = 0; i < options.numVectorProps; ++i)
+	{
+		mesh.vectorProps[i].assign(mesh.positions.begin(), mesh.positions.end());
+	}
+}
+
+static std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> declareProperties(const BenchOptions& options)
+{
+	std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> properties;
+	for(int i = 0; i < options.numFloatProps; ++i)
+	{
+		properties.emplace_back("float" + std::to_string(i), FLOAT, POINT);
+	}
+	for(int i = 0; i < options.numVectorProps; ++i)
+	{
+		properties.emplace_back("vector" + std::to_string(i), VECTOR, POINT);
+	}
+	return properties;
+}
+
+static double secondsSince(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchmarkSize(size_t numPoints, const BenchOptions& options, std::vector<BenchResult>& results)
+{
+	const std::string file = options.dir + "/easyAbcBench_" + std::to_string(numPoints) + ".abc";
+	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>> properties = declareProperties(options);
+
+	//generate up front so only the library is timed
+	std::vector<SyntheticMesh> frames(options.topologyChanges ? 2 : 1);
+	for(size_t i = 0; i < frames.size(); ++i)
+	{
+		generateMesh(frames[i], numPoints, (int)i, options);
+	}
+
+	//WRITE
+	{
+		AbcWriter writer(file, "xform", "mesh", properties);
+		double bytes = 0.0;
+		auto start = std::chrono::steady_clock::now();
+		for(int f = 0; f < options.frames; ++f)
+		{
+			const SyntheticMesh& mesh = frames[f % frames.size()];
+			writer.addSample(mesh.positions, mesh.faceIndices, mesh.faceCounts, mesh.normals, POINT, mesh.floatProps, mesh.vectorProps);
+			bytes += mesh.numBytes();
+		}
+		results.push_back(BenchResult{"AbcWriter::addSample", numPoints, options.frames, secondsSince(start), bytes});
+	}
+
+	//READ
+	AbcReader reader;
+	reader.openArchive(file, "xform", "mesh", properties);
+	const int numSamples = reader.getNumSamples();
+	const double bytesPerSample = frames[0].numBytes();
+
+	{
+		auto start = std::chrono::steady_clock::now();
+		reader.sampleSpecific(0);
+		int samples = 1;
+		while(reader.sampleForward())
+		{
+			++samples;
+		}
+		results.push_back(BenchResult{"AbcReader::sampleForward", numPoints, samples, secondsSince(start), samples * bytesPerSample});
+	}
+
+	{
+		std::vector<int> order(numSamples);
+		for(int i = 0; i < numSamples; ++i)
+		{
+			order[i] = i;
+		}
+		std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+		auto start = std::chrono::steady_clock::now();
+		for(int i : order)
+		{
+			reader.sampleSpecific(i);
+		}
+		results.push_back(BenchResult{"AbcReader::sampleSpecific", numPoints, numSamples, secondsSince(start), numSamples * bytesPerSample});
+	}
+
+	{
+		reader.setReadMode(READ_COPY);
+		auto start = std::chrono::steady_clock::now();
+		reader.sampleSpecific(0);
+		int samples = 1;
+		while(reader.sampleForward())
+		{
+			++samples;
+		}
+		results.push_back(BenchResult{"AbcReader::sampleForward(READ_COPY)", numPoints, samples, secondsSince(start), samples * bytesPerSample});
+		reader.setReadMode(READ_VIEW);
+	}
+
+	{
+		//touching only the positions decodes only the positions
+		reader.setLazyDecode(true);
+		const double positionBytes = frames[0].positions.size() * sizeof(Alembic::Abc::V3f);
+		volatile float sum = 0.0f;
+		auto start = std::chrono::steady_clock::now();
+		reader.sampleSpecific(0);
+		int samples = 0;
+		do
+		{
+			const AbcArrayView<Alembic::Abc::V3f>& positions = reader.getPositionsView();
+			sum += positions.empty() ? 0.0f : positions[0].x;
+			++samples;
+		}
+		while(reader.sampleForward());
+		results.push_back(BenchResult{"AbcReader::sampleForward(lazy, positions)", numPoints, samples, secondsSince(start), samples * positionBytes});
+		reader.setLazyDecode(false);
+	}
+
+	//PROPERTY ACCESS, by name and through handles, touching every element
+	const int accessRepeats = 100;
+	double propertyBytes = 0.0;
+	for(int i = 0; i < options.numFloatProps; ++i)
+	{
+		propertyBytes += reader.getFloatPropertyView("float" + std::to_string(i)).size() * sizeof(float);
+	}
+
+	//both cases sum every element locally and publish the total once, so only the lookup differs
+	{
+		double sum = 0.0;
+		auto start = std::chrono::steady_clock::now();
+		for(int r = 0; r < accessRepeats; ++r)
+		{
+			for(int i = 0; i < options.numFloatProps; ++i)
+			{
+				for(float v : reader.getFloatPropertyView("float" + std::to_string(i)))
+				{
+					sum += v;
+				}
+			}
+		}
+		results.push_back(BenchResult{"AbcReader::getFloatPropertyView(name)", numPoints, accessRepeats, secondsSince(start), accessRepeats * propertyBytes});
+		g_benchSink = sum;
+	}
+
+	{
+		std::vector<AbcPropertyHandle<float>> handles;
+		for(int i = 0; i < options.numFloatProps; ++i)
+		{
+			handles.push_back(reader.getPropertyHandle<float>("float" + std::to_string(i)));
+		}
+
+		double sum = 0.0;
+		auto start = std::chrono::steady_clock::now();
+		for(int r = 0; r < accessRepeats; ++r)
+		{
+			for(auto& handle : handles)
+			{
+				for(float v : reader.getProperty(handle))
+				{
+					sum += v;
+				}
+			}
+		}
+		results.push_back(BenchResult{"AbcReader::getProperty(handle)", numPoints, accessRepeats, secondsSince(start), accessRepeats * propertyBytes});
+		g_benchSink = sum;
+	}
+
+	std::remove(file.c_str());
+}
+
+static std::vector<size_t> parseSizes(const std::string& list)
+{
+	std::vector<size_t> sizes;
+	std::stringstream stream(list);
+	std::string item;
+	while(std::getline(stream, item, ','))
+	{
+		sizes.push_back(std::strtoull(item.c_str(), nullptr, 10));
+	}
+	return sizes;
+}
+
+static void writeResults(std::ostream& out, const std::vector<BenchResult>& results, const BenchOptions& options)
+{
+	bool json = options.format == "json";
+	if(json)
+	{
+		out << "[" << std::endl;
+	}
+	else
+	{
+		out << "benchmark,points,samples,float_props,vector_props,topology_changes,seconds,samples_per_sec,mb_per_sec" << std::endl;
+	}
+
+	for(size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& r = results[i];
+		double samplesPerSec = r.seconds > 0.0 ? r.samples / r.seconds : 0.0;
+		double mbPerSec = r.seconds > 0.0 ? r.bytes / (1024.0 * 1024.0) / r.seconds : 0.0;
+
+		if(json)
+		{
+			out << "  {\"benchmark\": \"" << r.name << "\", \"points\": " << r.points << ", \"samples\": " << r.samples
+				<< ", \"float_props\": " << options.numFloatProps << ", \"vector_props\": " << options.numVectorProps
+				<< ", \"topology_changes\": " << (options.topologyChanges ? "true" : "false")
+				<< ", \"seconds\": " << r.seconds << ", \"samples_per_sec\": " << samplesPerSec
+				<< ", \"mb_per_sec\": " << mbPerSec << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+		}
+		else
+		{
+			out << r.name << "," << r.points << "," << r.samples << "," << options.numFloatProps << "," << options.numVectorProps
+				<< "," << (options.topologyChanges ? 1 : 0) << "," << r.seconds << "," << samplesPerSec << "," << mbPerSec << std::endl;
+		}
+	}
+
+	if(json)
+	{
+		out << "]" << std::endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	options.sizes = {1000, 10000, 100000, 1000000};
+	options.frames = 10;
+	options.numFloatProps = 2;
+	options.numVectorProps = 2;
+	options.topologyChanges = false;
+	options.format = "csv";
+	options.dir = "/tmp";
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		bool hasValue = i + 1 < argc;
+		if(arg == "--sizes" && hasValue) options.sizes = parseSizes(argv[++i]);
+		else if(arg == "--frames" && hasValue) options.frames = std::atoi(argv[++i]);
+		else if(arg == "--float-props" && hasValue) options.numFloatProps = std::atoi(argv[++i]);
+		else if(arg == "--vector-props" && hasValue) options.numVectorProps = std::atoi(argv[++i]);
+		else if(arg == "--topology-changes") options.topologyChanges = true;
+		else if(arg == "--format" && hasValue) options.format = argv[++i];
+		else if(arg == "--dir" && hasValue) options.dir = argv[++i];
+		else if(arg == "--output" && hasValue) options.output = argv[++i];
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--sizes 1000,100000] [--frames 10] [--float-props 2] [--vector-props 2]"
+				<< " [--topology-changes] [--format csv|json] [--dir /tmp] [--output file]" << std::endl;
+			return 1;
+		}
+	}
+
+	//the library reports progress on std::cout, keep it out of the results
+	std::ofstream devNull("/dev/null");
+	std::streambuf* coutBuffer = std::cout.rdbuf(devNull.rdbuf());
+
+	std::vector<BenchResult> results;
+	for(size_t numPoints : options.sizes)
+	{
+		std::cerr << "Benchmarking " << numPoints << " points..." << std::endl;
+		benchmarkSize(numPoints, options, results);
+	}
+
+	std::cout.rdbuf(coutBuffer);
+
+	if(options.output.empty())
+	{
+		writeResults(std::cout, results, options);
+	}
+	else
+	{
+		std::ofstream out(options.output.c_str());
+		writeResults(out, results, options);
+	}
+
+	return 0;
+}
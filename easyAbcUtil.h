@@ -3,6 +3,11 @@ enum PROP_TYPE
 {
     FLOAT,
     VECTOR,
+    INT,
+    VECTOR2,
+    QUAT,
+    STRING,
+    NUM_PROP_TYPES,
 };
 
 enum PROP_SCOPE
@@ -10,4 +15,40 @@ enum PROP_SCOPE
     POINT,
     VERTEX,
     FACE,
-};
\ No newline at end of file
+};
+
+enum READ_MODE
+{
+    READ_VIEW,
+    READ_COPY,
+    READ_SOA,
+};
+
+enum NORMALS_MODE
+{
+    NORMALS_FROM_FILE,
+    NORMALS_GENERATE_MISSING,
+    NORMALS_GENERATE_ALWAYS,
+};
+
+enum PROP_ENCODING
+{
+    ENCODE_FLOAT32,
+    ENCODE_HALF,
+    ENCODE_QUANTIZED16,
+    ENCODE_UNORM8,
+};
+
+enum INTERPOLATION_MODE
+{
+    INTERPOLATE_NONE,
+    INTERPOLATE_LINEAR,
+    INTERPOLATE_VELOCITY,
+};
+
+enum OBJECT_TYPE
+{
+    OBJECT_XFORM,
+    OBJECT_POLYMESH,
+    OBJECT_OTHER,
+};
@@ -1,11 +1,251 @@
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 #include "AbcReader.h"
 #include "AbcWriter.h"
+#include "AbcQuantize.h"
+
+#include <Alembic/AbcCoreFactory/All.h>
+
+//! Largest error a value may pick up going through encoding and back
+static float encodingTolerance(PROP_ENCODING encoding, float value, float rangeMin, float rangeMax)
+{
+	switch(encoding)
+	{
+	case ENCODE_HALF:
+		//11 significant bits, plus the spacing of half subnormals
+		return std::abs(value) / 2048.0f + 6e-8f;
+	case ENCODE_QUANTIZED16:
+		return (rangeMax - rangeMin) / 65535.0f + std::abs(rangeMax) * 1e-6f + 1e-6f;
+	case ENCODE_UNORM8:
+		return 0.5f / 255.0f + 1e-6f;
+	default:
+		return 0.0f;
+	}
+}
+
+//! Values an encoding gives back in the best case, unorm8 clamps to [0, 1]
+static float encodable(PROP_ENCODING encoding, float value)
+{
+	return encoding == ENCODE_UNORM8 ? std::min(std::max(value, 0.0f), 1.0f) : value;
+}
+
+static bool checkDecoded(const std::string& what, PROP_ENCODING encoding, const float* original, const float* decoded, size_t count)
+{
+	float rangeMin = 0.0f;
+	float rangeMax = 0.0f;
+	for(size_t i = 0; i < count; ++i)
+	{
+		rangeMin = std::min(rangeMin, original[i]);
+		rangeMax = std::max(rangeMax, original[i]);
+	}
+
+	for(size_t i = 0; i < count; ++i)
+	{
+		const float expected = encodable(encoding, original[i]);
+		if(!(std::abs(decoded[i] - expected) <= encodingTolerance(encoding, expected, rangeMin, rangeMax)))
+		{
+			std::cout << "ERROR: " << what << ": value " << i << " is " << decoded[i] << " instead of " << expected << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+//! Encodes count scalars in one call (SSE steps plus the scalar tail) and element by element (scalar tail only),
+//! checks both give the same bits and decode to the originals within the encoding's precision
+static bool checkCodecs(size_t count, int extent)
+{
+	std::vector<float> values(count);
+	for(size_t i = 0; i < count; ++i)
+	{
+		//spread over [-1.5, 2.5] and across magnitudes, unorm8 gets values to clamp
+		values[i] = std::sin(i * 12.9898f + extent) * 2.0f + 0.5f;
+		values[i] *= (i % 7 == 0) ? 1e-3f : 1.0f;
+	}
+	const std::string what = std::to_string(count) + " scalars, extent " + std::to_string(extent);
+	bool ok = true;
+
+	//HALF
+	std::vector<Alembic::Util::float16_t> half(count);
+	std::vector<float> decoded(count);
+	encodeHalf(values.data(), count, half.data());
+	decodeHalf(half.data(), count, decoded.data());
+	for(size_t i = 0; i < count; ++i)
+	{
+		Alembic::Util::float16_t single;
+		encodeHalf(&values[i], 1, &single);
+		ok = ok && single.bits() == half[i].bits();
+	}
+	ok = checkDecoded("half, " + what, ENCODE_HALF, values.data(), decoded.data(), count) && ok;
+
+	//QUANTIZED16
+	float min[4];
+	float max[4];
+	componentRange(values.data(), count, extent, min, max);
+	std::vector<uint16_t> quantized(count);
+	quantize16(values.data(), count, extent, min, max, quantized.data());
+	dequantize16(quantized.data(), count, extent, min, max, decoded.data());
+	for(size_t i = 0; i + extent <= count; i += extent)
+	{
+		uint16_t single[4];
+		quantize16(&values[i], extent, extent, min, max, single);
+		ok = ok && std::equal(single, single + extent, &quantized[i]);
+	}
+	ok = checkDecoded("quantized16, " + what, ENCODE_QUANTIZED16, values.data(), decoded.data(), count) && ok;
+
+	//UNORM8
+	std::vector<uint8_t> unorm8(count);
+	encodeUnorm8(values.data(), count, unorm8.data());
+	decodeUnorm8(unorm8.data(), count, decoded.data());
+	for(size_t i = 0; i < count; ++i)
+	{
+		uint8_t single;
+		encodeUnorm8(&values[i], 1, &single);
+		ok = ok && single == unorm8[i];
+	}
+	ok = checkDecoded("unorm8, " + what, ENCODE_UNORM8, values.data(), decoded.data(), count) && ok;
+
+	if(!ok)
+	{
+		std::cout << "ERROR: Encoding " << what << " failed the round trip." << std::endl;
+	}
+	return ok;
+}
+
+//! Writes the sample with every property stored in encoding, reads it back and compares against the originals
+static bool checkEncodedArchive(const std::string& file, const std::string& xFormName, const std::string& meshName,
+	const std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>& properties, PROP_ENCODING encoding,
+	const std::vector<Alembic::Abc::V3f>& points, const std::vector<int>& faceIndices, const std::vector<int>& faceCounts,
+	const std::vector<Alembic::Abc::V3f>& normals, const std::vector<std::vector<float>>& floatProps, const std::vector<std::vector<Alembic::Abc::V3f>>& vectorProps)
+{
+	std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE, PROP_ENCODING>> encoded;
+	for(auto& p : properties)
+	{
+		encoded.emplace_back(std::get<0>(p), std::get<1>(p), std::get<2>(p), encoding);
+	}
+
+	{
+		AbcWriter writer(file, xFormName, meshName, encoded);
+		writer.addSample(points, faceIndices, faceCounts, normals, PROP_SCOPE::VERTEX,
+			floatProps, vectorProps);
+	}
+
+	AbcReader reader;
+	if(!reader.openArchive(file, xFormName, meshName, properties))
+	{
+		return false;
+	}
+
+	bool ok = true;
+	size_t floatIdx = 0;
+	size_t vectorIdx = 0;
+	for(auto& p : properties)
+	{
+		const std::string& name = std::get<0>(p);
+		const std::string what = file + " " + name;
+		if(std::get<1>(p) == FLOAT)
+		{
+			const std::vector<float>& original = floatProps[floatIdx++];
+			const AbcArrayView<float>& decoded = reader.getFloatPropertyView(name);
+			ok = decoded.size() == original.size() && checkDecoded(what, encoding, original.data(), decoded.data(), original.size()) && ok;
+		}
+		else
+		{
+			const std::vector<Alembic::Abc::V3f>& original = vectorProps[vectorIdx++];
+			const AbcArrayView<Alembic::Abc::V3f>& decoded = reader.getVectorPropertyView(name);
+			ok = decoded.size() == original.size()
+				&& checkDecoded(what, encoding, (const float*)original.data(), (const float*)decoded.data(), original.size() * 3) && ok;
+		}
+	}
+
+	std::cout << (ok ? "Round trip of [" : "ERROR: Round trip of [") << file << "] " << (ok ? "matches." : "failed.") << std::endl;
+	return ok;
+}
+
+//! Writes two samples, breaks the array block of the second one's positions and checks that readRange rethrows
+//! the decode error instead of waiting for a sample that never arrives
+static bool checkFailedDecode(const std::string& file, const std::string& xFormName, const std::string& meshName,
+	const std::vector<Alembic::Abc::V3f>& points, const std::vector<int>& faceIndices, const std::vector<int>& faceCounts)
+{
+	//no other array of the file holds these values
+	std::vector<Alembic::Abc::V3f> moved(points);
+	for(auto& p : moved)
+	{
+		p += Alembic::Abc::V3f(1000.25f, 2000.5f, 3000.75f);
+	}
+
+	{
+		AbcWriter writer(file, xFormName, meshName, std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>());
+		AbcWriterSample sample = writer.createSample();
+		sample.vertices = points;
+		sample.faceIndices = faceIndices;
+		sample.faceCounts = faceCounts;
+		writer.addSample(sample);
+		sample.vertices = moved;
+		writer.addSample(sample);
+	}
+
+	//an Ogawa array block is a uint64 size, a 16 byte digest, then the values. A size below the digest is invalid.
+	std::string bytes;
+	{
+		std::ifstream in(file.c_str(), std::ios::binary);
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		bytes = buffer.str();
+	}
+	const size_t found = bytes.find(std::string((const char*)moved.data(), sizeof(Alembic::Abc::V3f)));
+	if(found == std::string::npos || found < 24)
+	{
+		std::cout << "ERROR: Positions of the second sample not found in [" << file << "]." << std::endl;
+		return false;
+	}
+	const uint64_t brokenSize = 8;
+	bytes.replace(found - 24, sizeof(brokenSize), (const char*)&brokenSize, sizeof(brokenSize));
+	{
+		std::ofstream out(file.c_str(), std::ios::binary | std::ios::trunc);
+		out << bytes;
+	}
+
+	//the default policy throws, the reader's own archives would swallow the error
+	Alembic::AbcCoreFactory::IFactory factory;
+	Alembic::AbcCoreFactory::IFactory::CoreType coreType;
+	std::shared_ptr<Alembic::Abc::IArchive> archive =
+		std::make_shared<Alembic::Abc::IArchive>(factory.getArchive(file, coreType));
+	AbcReader reader;
+	if(!reader.openArchive(archive, xFormName, meshName, std::vector<std::tuple<std::string, PROP_TYPE, PROP_SCOPE>>()))
+	{
+		return false;
+	}
+
+	for(bool inOrder : {true, false})
+	{
+		bool rethrown = false;
+		try
+		{
+			reader.readRange(0, reader.getNumSamples(), [](const AbcSample&) {}, inOrder);
+		}
+		catch(const std::exception&)
+		{
+			rethrown = true;
+		}
+		if(!rethrown)
+		{
+			std::cout << "ERROR: readRange did not report the broken sample of [" << file << "]." << std::endl;
+			return false;
+		}
+	}
+	std::cout << "readRange rethrows the broken sample of [" << file << "]." << std::endl;
+	return true;
+}
 
 int main(int argc, char* argv[])
 {
@@ -23,11 +263,15 @@ int main(int argc, char* argv[])
 	//std::cout << "Opening archive..." << std::endl;
 	inputMesh.openArchive(inputMeshName, xFormName, meshName, customProperties);
 
-	//Access efficiently:
+	//Access efficiently (zero-copy views, valid in both read modes):
 	/*
-	const std::vector<float>& noise = inputMesh.getFloatProperty("noise");
-	const std::vector<float>& Cd = inputMesh.getFloatProperty("Cd");
-	const std::vector<Alembic::Abc::V3f>& vector_noise = inputMesh.getVectorProperty("vector_noise");
+	const AbcArrayView<float>& noise = inputMesh.getFloatPropertyView("noise");
+	const AbcArrayView<Alembic::Abc::V3f>& Cd = inputMesh.getVectorPropertyView("Cd");
+	const AbcArrayView<Alembic::Abc::V3f>& vector_noise = inputMesh.getVectorPropertyView("vector_noise");
+
+	//inside a frame loop, resolve once and skip the name lookup per sample:
+	AbcPropertyHandle<float> noiseHandle = inputMesh.getPropertyHandle<float>("noise");
+	const AbcArrayView<float>& noise = inputMesh.getProperty(noiseHandle);
 	*/
 
 	//copying works like this:
@@ -53,4 +297,26 @@ int main(int argc, char* argv[])
 	outputMesh.addSample(points, faceIndices, faceCounts, normals, PROP_SCOPE::VERTEX,
 		floatProps,
 		vectorProps);
+
+	//reduced precision encodings: the codecs on their own, with counts that leave a scalar tail behind the
+	//SSE steps, then the test geometry written with each encoding and read back
+	bool ok = true;
+	for(int extent : {1, 3})
+	{
+		for(size_t elements : {1, 3, 4, 5, 13, 25, 1000, 1003})
+		{
+			ok = checkCodecs(elements * extent, extent) && ok;
+		}
+	}
+
+	const std::pair<PROP_ENCODING, std::string> encodings[] = {
+		{ENCODE_HALF, "half"}, {ENCODE_QUANTIZED16, "quantized16"}, {ENCODE_UNORM8, "unorm8"}};
+	for(auto& encoding : encodings)
+	{
+		ok = checkEncodedArchive("testGeo/non_animated_" + encoding.second + ".abc", xFormName, meshName, customProperties,
+			encoding.first, points, faceIndices, faceCounts, normals, floatProps, vectorProps) && ok;
+	}
+
+	ok = checkFailedDecode("testGeo/non_animated_broken.abc", xFormName, meshName, points, faceIndices, faceCounts) && ok;
+	return ok ? 0 : 1;
 }
\ No newline at end of file